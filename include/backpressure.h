@@ -0,0 +1,68 @@
+#ifndef BACKPRESSURE_H
+#define BACKPRESSURE_H
+
+#include <cstdint>
+#include <string>
+
+#include "bench_config.h"
+
+/// What a producer does when the queue of an edge is full
+enum class overflow_policy {
+    block,        // wait for space (lossless; overload slows the producer down)
+    drop_newest,  // discard the items that do not fit
+    drop_oldest,  // evict the oldest queued items to make room (needs a multi-consumer queue)
+    sample        // over half full, admit 1 in BenchConfig::sample_every items; drop the rest
+};
+
+// Default sampling rate of overflow_policy::sample
+constexpr int default_sample_every = 4;
+
+/// Producer-side counters of a queue, one per policy outcome
+struct backpressure_stats
+{
+    std::uint64_t blocked = 0;         // waits for space (block)
+    std::uint64_t dropped_newest = 0;  // items discarded on arrival (drop_newest)
+    std::uint64_t dropped_oldest = 0;  // queued items evicted (drop_oldest)
+    std::uint64_t sampled_out = 0;     // items skipped by sampling or not fitting (sample)
+
+    std::uint64_t dropped( void ) const { return dropped_newest + dropped_oldest + sampled_out; }
+
+    backpressure_stats &operator+=( const backpressure_stats &o )
+    {
+        blocked += o.blocked;
+        dropped_newest += o.dropped_newest;
+        dropped_oldest += o.dropped_oldest;
+        sampled_out += o.sampled_out;
+        return *this;
+    }
+
+    // Counts accumulated since an earlier snapshot
+    backpressure_stats since( const backpressure_stats &earlier ) const
+    {
+        backpressure_stats d;
+        d.blocked = blocked - earlier.blocked;
+        d.dropped_newest = dropped_newest - earlier.dropped_newest;
+        d.dropped_oldest = dropped_oldest - earlier.dropped_oldest;
+        d.sampled_out = sampled_out - earlier.sampled_out;
+        return d;
+    }
+};
+
+// Parse "block", "drop_newest", "drop_oldest" or "sample"
+bool overflow_policy_from_string(const std::string &s, overflow_policy &policy);
+const char *overflow_policy_name(overflow_policy policy);
+
+// Key of an edge in BenchConfig::edge_backpressure
+std::string edge_key(const std::string &from, const std::string &to);
+
+// Policy of the edge from -> to as selected in cfg (block without cfg).
+// Throws std::invalid_argument on an unknown name
+overflow_policy overflow_policy_for(const BenchConfig *cfg, const std::string &from, const std::string &to);
+
+// Sampling rate from cfg (at least 1)
+inline int sample_every_of(const BenchConfig *cfg)
+{
+    return (cfg && cfg->sample_every > 0) ? cfg->sample_every : default_sample_every;
+}
+
+#endif // BACKPRESSURE_H
@@ -1,24 +1,59 @@
 #ifndef BENCH_CONFIG_H
 #define BENCH_CONFIG_H
 
+#include <cstddef>
 #include <cstdint>
+#include <map>
 #include <string>
 #include <cstdio>
 
 struct BenchConfig {
-    int threads = 4; // not used for now
-    int producers = 1;
-    int consumers = 1;
-    int batch_size = 1;
-    int queue_capacity = 0;
+    int threads = 4; // worker threads when executor == "pool"
+    int producers = 1; // source_B instances (producers of process_B work), default topology only
+    int consumers = 1; // process_B instances, default topology only
+    int batch_size = 1; // max items taken from a stage queue per wakeup
+    int queue_capacity = 0; // capacity of each stage queue (0 = default_queue_capacity)
+    std::string pipeline_file = ""; // stage graph file (see PipelineBuilder); empty = default topology
+    std::string executor = "dedicated"; // "dedicated" (one std::thread per stage) or "pool" (work-stealing)
+    std::string affinity = "none"; // stage threads: "none" or "auto" (neighbouring stages on sibling cores, queues on the consumer's NUMA node)
+    std::map<std::string, std::string> stage_affinity; // per-stage CPU list, overrides auto ("sA" -> "0-1,4"; dedicated executor)
+    std::string wait_strategy = "adaptive"; // how stages wait for data/space: spin, pause, yield, park or adaptive (spin budget learned per channel)
+    std::string backpressure = "block"; // full queue: block, drop_newest, drop_oldest or sample (see overflow_policy)
+    std::map<std::string, std::string> edge_backpressure; // per-edge override ("sA:pcA" -> "drop_oldest")
+    int sample_every = 0; // items admitted by the sample policy over half full: 1 in N (0 = default_sample_every)
+    std::map<std::string, std::string> channel_waits; // per-stage override: input queue of a consumer, read() channel of a source ("pcB" -> "spin")
     int work_us = 0; // microseconds of simulated work per processed item
+    std::string workload = "sleep"; // kernel simulating stage work: sleep, spin, hash, memory, pointer_chase
+    std::map<std::string, std::string> stage_workloads; // per-stage override ("sA", "sB", "pcA", "pcB" -> kernel)
+    std::size_t workload_bytes = 0; // working set of memory/pointer_chase kernels (0 = default, 8 MiB)
     int duration_s = 1; // seconds
+    int duration_ms = 0; // measurement window in milliseconds; overrides duration_s when > 0
+    int warm_in_ms = 0; // time after start() before the window opens (not measured)
+    int interval_ms = 0; // throughput sample period inside the window (0 = no interval samples)
     int warmup = 0; // number of warmup runs
     int repeats = 1; // number of repeats
+    std::string shutdown = "cancel"; // end of the benchmark: cancel (interrupt waits and work) or drain (flush queued items first)
     unsigned int seed = 0;
     std::string out_file = ""; // optional path to append per-run CSV results
     std::string profile_file = ""; // file path to write profile events (thread,time,status)
+    std::string profile_clock = "steady"; // profile timestamps: "steady" or "tsc" (calibrated rdtsc, x86 Linux)
+    std::string profile_format = ""; // "binary", "csv" or "" (csv for *.csv paths, binary otherwise)
+    int profile_sample_every = 0; // record 1 in N zones, per thread and zone (0/1 = all)
+    int profile_capture_ms = 0; // > 0: record zones only for this long after each capture trigger (window open, SIGUSR1)
+    int profile_budget = 0; // > 0: at most this many zones recorded per second
+    std::string profile_report = ""; // per-zone utilization over the measured windows, written at exit ("-" = stdout)
 };
 
+// Capacity requested for stage queues (0 lets the queue use its default)
+inline std::size_t queue_capacity_of(const BenchConfig *cfg)
+{
+    return (cfg && cfg->queue_capacity > 0) ? (std::size_t)cfg->queue_capacity : 0;
+}
+
+// Batch size used by stages (at least 1)
+inline std::size_t batch_size_of(const BenchConfig *cfg)
+{
+    return (cfg && cfg->batch_size > 1) ? (std::size_t)cfg->batch_size : 1;
+}
 
 #endif // BENCH_CONFIG_H
@@ -2,14 +2,51 @@
 #define BENCH_METRICS_H
 
 #include <atomic>
+#include <cstddef>
 
-inline std::atomic<long long>& processed_items_storage() {
-    static std::atomic<long long> inst{0};
+#include "cache_line.h"
+
+// Counter split into cache-line-padded shards. Each thread increments its
+// own shard with relaxed atomics, so concurrent consumers do not bounce one
+// cache line; readers sum all shards.
+class sharded_counter {
+public:
+    static constexpr std::size_t shard_count = 64;
+
+    void add(long long v) { shards_[shard_index()].value.fetch_add(v, std::memory_order_relaxed); }
+
+    long long get() const {
+        long long sum = 0;
+        for (const shard &s : shards_) sum += s.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    void reset() {
+        for (shard &s : shards_) s.value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(cache_line_size) shard {
+        std::atomic<long long> value{0};
+    };
+
+    // Threads take shards round-robin on first use (shared only beyond shard_count threads)
+    static std::size_t shard_index() {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+        return index;
+    }
+
+    shard shards_[shard_count];
+};
+
+inline sharded_counter& processed_items_storage() {
+    static sharded_counter inst;
     return inst;
 }
 
-inline void reset_processed_items() { processed_items_storage().store(0); }
-inline void inc_processed_items(long long v=1) { processed_items_storage().fetch_add(v); }
-inline long long get_processed_items() { return processed_items_storage().load(); }
+inline void reset_processed_items() { processed_items_storage().reset(); }
+inline void inc_processed_items(long long v=1) { processed_items_storage().add(v); }
+inline long long get_processed_items() { return processed_items_storage().get(); }
 
 #endif // BENCH_METRICS_H
@@ -0,0 +1,10 @@
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <cstddef>
+
+/// Tamanho (bytes) assumido para uma linha de cache.
+/// Usado para separar variáveis escritas por threads diferentes (evita false sharing).
+constexpr std::size_t cache_line_size = 64;
+
+#endif // CACHE_LINE_H
@@ -0,0 +1,267 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "thread_utils.h"
+#include "event_count.h"
+#include "backpressure.h"
+
+/// Capacidade usada quando BenchConfig::queue_capacity não é informado
+constexpr std::size_t default_queue_capacity = 64;
+
+/**
+ * @brief Interface de fila entre estágios do pipeline
+ *
+ * Implementada por spsc_ring (um produtor, um consumidor) e mpmc_queue
+ * (vários produtores e consumidores). As operações try_* nunca bloqueiam;
+ * push_wait()/pop_wait() bloqueiam via event_count, sem mutex no caminho
+ * rápido. Com a fila cheia, publish_batch() segue a overflow_policy da
+ * aresta e conta bloqueios e descartes em backpressure().
+ *
+ * @tparam T tipo transportado
+ */
+template <typename T>
+class channel
+{
+    /// Sinalizado a cada item inserido
+    event_count data_ready_;
+
+    /// Sinalizado a cada item removido (libera produtor com fila cheia)
+    event_count space_ready_;
+
+    /// Contadores de fila cheia, atualizados só nesse caminho
+    std::atomic<std::uint64_t> blocked_{0};
+    std::atomic<std::uint64_t> dropped_newest_{0};
+    std::atomic<std::uint64_t> dropped_oldest_{0};
+    std::atomic<std::uint64_t> sampled_out_{0};
+
+    /// overflow_policy::sample: 1 em sample_every_ itens acima de meia fila
+    int sample_every_ = default_sample_every;
+    std::atomic<std::uint64_t> sample_tick_{0};
+
+    /**
+     * @brief Publicação com overflow_policy::sample
+     *
+     * Abaixo de meia fila todos os itens entram; acima, só 1 em
+     * sample_every_. Itens que não cabem são descartados.
+     */
+    std::size_t publish_sampled( const T *items, std::size_t n )
+    {
+        std::size_t inserted = 0;
+        for( std::size_t i = 0; i < n; i++ )
+        {
+            bool admit = size() * 2 < capacity() ||
+                         sample_tick_.fetch_add(1, std::memory_order_relaxed) % (std::uint64_t)sample_every_ == 0;
+            if( admit && try_push(items[i]) )
+                inserted++;
+            else
+                sampled_out_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if( inserted == 1 ) data_ready_.notify_one();
+        else if( inserted > 1 ) data_ready_.notify_all();
+        return n;
+    }
+
+    public:
+        virtual ~channel() = default;
+
+        /// Insere sem bloquear; false se cheia
+        virtual bool try_push( const T &value ) = 0;
+
+        /// Remove sem bloquear; false se vazia
+        virtual bool try_pop( T &value ) = 0;
+
+        /// Número aproximado de itens na fila
+        virtual std::size_t size( void ) const = 0;
+
+        virtual std::size_t capacity( void ) const = 0;
+
+        bool empty( void ) const { return size() == 0; }
+
+        /**
+         * @brief O produtor pode remover itens (overflow_policy::drop_oldest)
+         *
+         * Falso em filas de consumidor único, onde só o consumidor remove;
+         * nelas drop_oldest age como drop_newest.
+         */
+        virtual bool evictable( void ) const { return true; }
+
+        /// Taxa de overflow_policy::sample: 1 em n itens acima de meia fila
+        void set_sample_every( int n ) { sample_every_ = n > 0 ? n : 1; }
+
+        /// Bloqueios e descartes por fila cheia desde a criação
+        backpressure_stats backpressure( void ) const
+        {
+            backpressure_stats s;
+            s.blocked = blocked_.load(std::memory_order_relaxed);
+            s.dropped_newest = dropped_newest_.load(std::memory_order_relaxed);
+            s.dropped_oldest = dropped_oldest_.load(std::memory_order_relaxed);
+            s.sampled_out = sampled_out_.load(std::memory_order_relaxed);
+            return s;
+        }
+
+        /**
+         * @brief Define como produtores e consumidores esperam nesta fila
+         *
+         * Vale para read_batch() (fila vazia) e publish_batch() (fila cheia).
+         */
+        void set_wait_strategy( wait_strategy s )
+        {
+            data_ready_.set_strategy(s);
+            space_ready_.set_strategy(s);
+        }
+
+        wait_strategy get_wait_strategy( void ) const { return data_ready_.strategy(); }
+
+        /// Esperas por dados que dormiram (as demais terminaram em spin)
+        std::uint64_t data_parks( void ) const { return data_ready_.parks(); }
+
+        /**
+         * @brief Insere até n itens sem bloquear
+         *
+         * A implementação padrão insere um a um; filas podem publicar o
+         * lote inteiro com uma única atualização de índice.
+         *
+         * @return quantidade inserida (prefixo de items)
+         */
+        virtual std::size_t try_push_batch( const T *items, std::size_t n )
+        {
+            std::size_t i = 0;
+            while( i < n && try_push(items[i]) ) i++;
+            return i;
+        }
+
+        /**
+         * @brief Remove até max itens sem bloquear
+         *
+         * @return quantidade removida, em ordem, para out[0..]
+         */
+        virtual std::size_t try_pop_batch( T *out, std::size_t max )
+        {
+            std::size_t i = 0;
+            while( i < max && try_pop(out[i]) ) i++;
+            return i;
+        }
+
+        /**
+         * @brief Insere um item, bloqueando enquanto a fila estiver cheia
+         *
+         * @param value item
+         * @param producer thread produtora; a espera termina se ela for parada
+         * @return false se o produtor foi parado antes de inserir
+         */
+        bool push_wait( const T &value, thread_base &producer )
+        {
+            return publish_batch(&value, 1, producer) == 1;
+        }
+
+        /**
+         * @brief Acorda produtores e consumidores em espera, sem alterar a fila
+         *
+         * Usada ao parar o pipeline: as esperas terminam e os estágios
+         * verificam isActive() sem aguardar stage_wait_timeout.
+         */
+        void wake_all( void )
+        {
+            data_ready_.notify_all();
+            space_ready_.notify_all();
+        }
+
+        /**
+         * @brief Insere n itens; com a fila cheia segue a política da aresta
+         *
+         * Os consumidores são notificados uma vez por trecho inserido, não
+         * uma vez por item. Com block o produtor espera por espaço; as
+         * demais políticas nunca esperam e contam o que descartam.
+         *
+         * @param items itens contíguos
+         * @param n quantidade
+         * @param producer thread produtora; a espera termina se ela for parada
+         * @param policy o que fazer com a fila cheia
+         * @return quantidade inserida ou descartada (menor que n somente se
+         *         o produtor parou durante uma espera)
+         */
+        std::size_t publish_batch( const T *items, std::size_t n, thread_base &producer,
+                                   overflow_policy policy = overflow_policy::block )
+        {
+            if( policy == overflow_policy::sample )
+                return publish_sampled(items, n);
+
+            std::size_t done = 0;
+            while( done < n )
+            {
+                unsigned key = space_ready_.prepare_wait();
+                std::size_t k = try_push_batch(items + done, n - done);
+                if( k > 0 )
+                {
+                    done += k;
+                    if( k == 1 ) data_ready_.notify_one();
+                    else data_ready_.notify_all();
+                    continue;
+                }
+
+                if( policy == overflow_policy::drop_oldest && evictable() )
+                {
+                    T victim;
+                    if( try_pop(victim) )
+                        dropped_oldest_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if( policy != overflow_policy::block )
+                {
+                    dropped_newest_.fetch_add(n - done, std::memory_order_relaxed);
+                    return n;
+                }
+
+                if( !producer.isActive() ) break;
+                blocked_.fetch_add(1, std::memory_order_relaxed);
+                // On the pool the consumer may be queued behind us: run it (or another task) instead
+                thread_pool *pool = thread_pool::current();
+                if( pool && pool->run_pending() ) continue;
+                space_ready_.wait_for(key, producer.wait_timeout());
+            }
+            return done;
+        }
+
+        /**
+         * @brief Remove um item, esperando no máximo stage_wait_timeout
+         *
+         * @param value recebe o item
+         * @return false se nenhum item chegou a tempo
+         */
+        bool pop_wait( T &value )
+        {
+            return read_batch(&value, 1) == 1;
+        }
+
+        /**
+         * @brief Remove até max itens, esperando no máximo timeout
+         *
+         * Retorna assim que houver ao menos um item; não espera completar o lote.
+         *
+         * @param out destino contíguo com espaço para max itens
+         * @param max tamanho máximo do lote
+         * @param timeout espera com a fila vazia (um estágio passa wait_timeout())
+         * @return quantidade lida (0 se nada chegou a tempo)
+         */
+        std::size_t read_batch( T *out, std::size_t max, std::chrono::milliseconds timeout = stage_wait_timeout )
+        {
+            unsigned key = data_ready_.prepare_wait();
+            std::size_t n = try_pop_batch(out, max);
+            if( n == 0 )
+            {
+                data_ready_.wait_for(key, timeout);
+                n = try_pop_batch(out, max);
+                if( n == 0 ) return 0;
+            }
+
+            if( n == 1 ) space_ready_.notify_one();
+            else space_ready_.notify_all();
+            return n;
+        }
+};
+
+#endif // CHANNEL_H
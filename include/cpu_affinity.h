@@ -0,0 +1,69 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#define CPU_AFFINITY_SUPPORTED 1
+#else
+#define CPU_AFFINITY_SUPPORTED 0
+#endif
+
+// CPU numbers must be below this (CPU_SETSIZE, the size of a cpu_set_t)
+constexpr int max_cpus = 1024;
+
+// One logical CPU the process may run on
+struct cpu_info {
+    int cpu;
+    int core;     // physical core id within the package (SMT siblings share it)
+    int package;  // socket
+    int node;     // NUMA node (0 when unknown)
+};
+
+// CPUs of the process affinity mask and their topology, read from Linux
+// sysfs. Elsewhere (or when sysfs is missing) every CPU is its own core on
+// package 0, node 0.
+class cpu_topology {
+public:
+    cpu_topology() = default;
+
+    // A given set of CPUs, e.g. a synthetic layout for tests
+    explicit cpu_topology(std::vector<cpu_info> cpus) : cpus_(std::move(cpus)) {}
+
+    static cpu_topology detect();
+
+    const std::vector<cpu_info> &cpus() const { return cpus_; }
+
+    int node_count() const;
+
+    // NUMA node of cpu, -1 if cpu is not in the set
+    int node_of(int cpu) const;
+
+    // CPUs ordered so that neighbours are as close as possible: SMT siblings
+    // next to each other, then the other cores of the same package and node
+    std::vector<int> placement_order() const;
+
+private:
+    std::vector<cpu_info> cpus_;
+};
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}. False on a syntax error, an empty list
+// or a CPU >= max_cpus
+bool parse_cpu_list(const std::string &s, std::vector<int> &cpus);
+
+// Restrict the calling thread to cpus; an empty list is a no-op.
+// False when unsupported or rejected by the kernel
+bool pin_current_thread(const std::vector<int> &cpus);
+
+// CPUs the calling thread may run on, as the kernel reports them; empty when
+// unsupported
+std::vector<int> current_thread_cpus();
+
+// Run fn on a short-lived thread pinned to cpus and wait for it. Memory that
+// fn touches first lands on those CPUs' NUMA node (Linux first-touch policy)
+void run_pinned(const std::vector<int> &cpus, const std::function<void()> &fn);
+
+#endif // CPU_AFFINITY_H
@@ -0,0 +1,200 @@
+#ifndef EVENT_COUNT_H
+#define EVENT_COUNT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "wait_strategy.h"
+
+/**
+ * @brief Ponto de espera para estruturas lock-free
+ *
+ * Permite que uma thread durma até que outra sinalize um evento, sem que
+ * o lado que sinaliza precise adquirir mutex quando ninguém está esperando.
+ *
+ * Uso (lado que espera):
+ *   key = ev.prepare_wait();
+ *   if( !condicao() ) ev.wait_for( key, timeout );
+ *
+ * Uso (lado que sinaliza):
+ *   altera_estado(); ev.notify_all();
+ *
+ * A espera segue a wait_strategy configurada: as variantes de spin só
+ * observam a época, sem se registrar como waiters, então o lado que
+ * sinaliza não toca no mutex nem faz syscall para acordá-las. Com
+ * adaptive (padrão) o orçamento de spin se ajusta ao intervalo observado
+ * entre as esperas e os eventos; com uma única CPU nunca há spin.
+ */
+class event_count
+{
+    /// Incrementado a cada notificação
+    std::atomic<unsigned> epoch_{0};
+
+    /// Número de threads bloqueadas (ou prestes a bloquear) em wait_for()
+    std::atomic<int> waiters_{0};
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+
+    std::atomic<wait_strategy> strategy_{wait_strategy::adaptive};
+
+    /// Orçamento de spin aprendido (adaptive), em ns
+    std::atomic<std::int64_t> spin_budget_ns_{adaptive_spin_min.count()};
+
+    /// Esperas que precisaram dormir na condition variable
+    std::atomic<std::uint64_t> parks_{0};
+
+    typedef std::chrono::steady_clock wait_clock;
+
+    /**
+     * @brief Espera ativa até a época mudar ou until
+     *
+     * @param yield_after iterações com pause antes de passar a ceder a CPU
+     *                    (negativo = nunca cede)
+     * @param relax usa cpu_relax() entre as verificações
+     */
+    bool spin_until( unsigned key, wait_clock::time_point until, int yield_after, bool relax )
+    {
+        for( unsigned i = 0; ; i++ )
+        {
+            if( epoch_.load(std::memory_order_acquire) != key ) return true;
+            if( (i & 31) == 31 && wait_clock::now() >= until )
+                return epoch_.load(std::memory_order_acquire) != key;
+
+            if( yield_after >= 0 && i >= (unsigned)yield_after ) std::this_thread::yield();
+            else if( relax ) cpu_relax();
+        }
+    }
+
+    /**
+     * @brief Dorme na condition variable até a notificação ou until
+     */
+    bool park_until( unsigned key, wait_clock::time_point until )
+    {
+        parks_.fetch_add(1, std::memory_order_relaxed);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        bool notified;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            notified = cv_.wait_until(lk, until, [&] {
+                return epoch_.load(std::memory_order_seq_cst) != key;
+            });
+        }
+        waiters_.fetch_sub(1, std::memory_order_release);
+        return notified;
+    }
+
+    public:
+        /**
+         * @brief Captura a época atual, antes de verificar a condição
+         *
+         * @return chave a ser passada para wait_for()
+         */
+        unsigned prepare_wait( void ) const
+        {
+            return epoch_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Bloqueia até uma notificação posterior a key, ou timeout
+         *
+         * @param key valor retornado por prepare_wait()
+         * @param timeout tempo máximo de espera
+         * @return true houve notificação
+         * @return false expirou o timeout
+         */
+        template <typename Rep, typename Period>
+        bool wait_for( unsigned key, const std::chrono::duration<Rep, Period> &timeout )
+        {
+            const wait_clock::time_point start = wait_clock::now();
+            const wait_clock::time_point deadline = start + std::chrono::duration_cast<wait_clock::duration>(timeout);
+
+            switch( strategy() )
+            {
+                case wait_strategy::spin:
+                    return spin_until(key, deadline, -1, false);
+
+                case wait_strategy::pause:
+                    return spin_until(key, deadline, -1, true);
+
+                case wait_strategy::yield:
+                    return spin_until(key, deadline, 64, true);
+
+                case wait_strategy::park:
+                    if( spin_until(key, std::min(deadline, start + park_spin_budget), -1, true) )
+                        return true;
+                    return park_until(key, deadline);
+
+                case wait_strategy::adaptive:
+                    break;
+            }
+
+            if( !spinning_pays_off() )
+                return park_until(key, deadline);
+
+            std::chrono::nanoseconds budget(spin_budget_ns_.load(std::memory_order_relaxed));
+            if( spin_until(key, std::min(deadline, start + std::chrono::duration_cast<wait_clock::duration>(budget)), -1, true) )
+                return true;
+
+            bool notified = park_until(key, deadline);
+            budget = adapt_spin_budget(budget, notified, wait_clock::now() - start);
+            spin_budget_ns_.store(budget.count(), std::memory_order_relaxed);
+            return notified;
+        }
+
+        /**
+         * @brief Define como wait_for() espera
+         *
+         * Pode ser trocada a qualquer momento; vale para as próximas esperas.
+         */
+        void set_strategy( wait_strategy s ) { strategy_.store(s, std::memory_order_relaxed); }
+
+        wait_strategy strategy( void ) const { return strategy_.load(std::memory_order_relaxed); }
+
+        /// Orçamento de spin atual da estratégia adaptive
+        std::chrono::nanoseconds spin_budget( void ) const
+        {
+            return std::chrono::nanoseconds(spin_budget_ns_.load(std::memory_order_relaxed));
+        }
+
+        /// Quantas esperas dormiram na condition variable (as demais terminaram em spin)
+        std::uint64_t parks( void ) const { return parks_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Acorda ao menos uma thread em espera
+         *
+         * Para quando o evento só pode ser aproveitado por um consumidor
+         * (ex.: um item em fila com vários consumidores).
+         */
+        void notify_one( void )
+        {
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+            if( waiters_.load(std::memory_order_seq_cst) > 0 )
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                cv_.notify_one();
+            }
+        }
+
+        /**
+         * @brief Acorda todas as threads em espera
+         *
+         * Só adquire o mutex quando existe alguma thread esperando.
+         */
+        void notify_all( void )
+        {
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+            if( waiters_.load(std::memory_order_seq_cst) > 0 )
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                cv_.notify_all();
+            }
+        }
+};
+
+#endif // EVENT_COUNT_H
@@ -0,0 +1,79 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+// Current steady_clock time in nanoseconds, used for every latency sample
+inline long long latency_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lock-free log-bucketed histogram of nanosecond latencies (HDR style).
+// Values below 2*sub_buckets are exact; above that every power of two is
+// split into sub_buckets linear buckets, so the relative error is < 1/32.
+// record() is a few relaxed atomic adds and may be called from any thread.
+class latency_histogram {
+public:
+    static constexpr unsigned sub_bits = 5;
+    static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bits;
+    static constexpr std::size_t bucket_count = (64 - sub_bits + 1) * sub_buckets;
+
+    latency_histogram() { reset(); }
+
+    latency_histogram(const latency_histogram &) = delete;
+    latency_histogram &operator=(const latency_histogram &) = delete;
+
+    void record(long long ns)
+    {
+        unsigned long long v = ns > 0 ? (unsigned long long)ns : 0;
+        buckets_[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        unsigned long long m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    }
+
+    unsigned long long count() const { return count_.load(std::memory_order_relaxed); }
+    long long max() const { return (long long)max_.load(std::memory_order_relaxed); }
+
+    // Smallest bucket upper bound covering a fraction q (0..1] of the samples,
+    // capped at max(); 0 when empty
+    long long percentile(double q) const;
+
+    void reset();
+
+    static std::size_t bucket_of(unsigned long long v)
+    {
+        if (v < 2 * sub_buckets) return (std::size_t)v;
+        unsigned shift = 63 - (unsigned)__builtin_clzll(v) - sub_bits;
+        return shift * sub_buckets + (std::size_t)(v >> shift);
+    }
+
+    // Largest value stored in bucket idx
+    static unsigned long long bucket_upper(std::size_t idx);
+
+private:
+    std::atomic<unsigned long long> buckets_[bucket_count];
+    std::atomic<unsigned long long> count_;
+    std::atomic<unsigned long long> max_;
+};
+
+// Latencies collected by one Pipeline
+struct pipeline_metrics {
+    // Duration of each stage cycle (same span as the profile zones)
+    latency_histogram sA, sB, pcA, pcB;
+
+    // From the source_A publish to the end of process_B, per item
+    latency_histogram end_to_end;
+
+    void reset() {
+        sA.reset(); sB.reset(); pcA.reset(); pcB.reset();
+        end_to_end.reset();
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_H
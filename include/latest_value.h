@@ -0,0 +1,93 @@
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+#include <chrono>
+
+#include "event_count.h"
+#include "seqlock.h"
+
+/**
+ * @brief Canal "último valor" para leitores em broadcast
+ *
+ * Um único escritor publica; qualquer número de leitores lê o valor mais
+ * recente sem lock (seqlock, leituras rasgadas são repetidas). Valores
+ * intermediários podem ser pulados. Leitores que precisam de um valor
+ * novo esperam num event_count, que só adquire mutex no lado do escritor
+ * quando existe alguém esperando: adicionar leitores não custa nada ao
+ * produtor.
+ *
+ * Uso (escritor):
+ *   ch.publish( v );
+ *
+ * Uso (leitor):
+ *   T v = ch.read();
+ *   ch.wait_for( v, [&]( const T &x ) { return x.seq > last; }, timeout );
+ *
+ * @tparam T tipo trivialmente copiável
+ */
+template <typename T>
+class latest_value
+{
+    seqlock<T> value_;
+
+    /// Sinalizado a cada publicação
+    event_count updated_;
+
+    public:
+        explicit latest_value( const T &initial = T() ) : value_(initial) {}
+
+        latest_value( const latest_value & ) = delete;
+        latest_value &operator=( const latest_value & ) = delete;
+
+        /**
+         * @brief Publica um novo valor (somente uma thread escritora)
+         */
+        void publish( const T &value )
+        {
+            value_.store(value);
+            updated_.notify_all();
+        }
+
+        /**
+         * @brief Valor mais recente, sem bloquear
+         */
+        T read( void ) const { return value_.load(); }
+
+        /// Como leitores esperam em wait_for()
+        void set_wait_strategy( wait_strategy s ) { updated_.set_strategy(s); }
+
+        /// Número de publicações já concluídas
+        unsigned version( void ) const { return value_.version(); }
+
+        /**
+         * @brief Espera um valor aceito por accept, no máximo timeout
+         *
+         * Retorna imediatamente se o valor atual já é aceito.
+         *
+         * @param out recebe o valor aceito (inalterado em timeout)
+         * @param accept predicado sobre o valor, ex.: seq maior que o último lido
+         * @param timeout tempo máximo de espera
+         * @return false se nenhum valor aceito chegou a tempo
+         */
+        template <typename Pred, typename Rep, typename Period>
+        bool wait_for( T &out, Pred accept, const std::chrono::duration<Rep, Period> &timeout )
+        {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            for( ;; )
+            {
+                unsigned key = updated_.prepare_wait();
+                T v = value_.load();
+                if( accept(v) )
+                {
+                    out = v;
+                    return true;
+                }
+
+                auto now = std::chrono::steady_clock::now();
+                if( now >= deadline ) return false;
+                updated_.wait_for(key, deadline - now);
+            }
+        }
+};
+
+#endif // LATEST_VALUE_H
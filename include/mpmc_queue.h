@@ -0,0 +1,127 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <cstdint>
+#include <memory>
+
+#include "cache_line.h"
+#include "channel.h"
+
+/**
+ * @brief Fila limitada lock-free, vários produtores e vários consumidores
+ *
+ * Algoritmo de D. Vyukov: cada posição guarda um número de sequência que
+ * indica se ela está livre para a volta atual do produtor (seq == pos) ou
+ * preenchida para o consumidor (seq == pos + 1). Produtores e consumidores
+ * disputam apenas o próprio índice via CAS, em linhas de cache separadas.
+ *
+ * A capacidade é arredondada para a próxima potência de 2 (mínimo 2).
+ *
+ * @tparam T tipo armazenado (copiável; removido da posição por move)
+ */
+template <typename T>
+class mpmc_queue : public channel<T>
+{
+    struct cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    public:
+        /**
+         * @brief Cria a fila
+         *
+         * @param capacity número mínimo de elementos (0 usa default_queue_capacity)
+         */
+        explicit mpmc_queue( std::size_t capacity = default_queue_capacity )
+        {
+            std::size_t cap = 2;
+            if( capacity == 0 ) capacity = default_queue_capacity;
+            while( cap < capacity ) cap <<= 1;
+
+            cells_.reset(new cell[cap]);
+            mask_ = cap - 1;
+            for( std::size_t i = 0; i < cap; i++ )
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_queue( const mpmc_queue & ) = delete;
+        mpmc_queue &operator=( const mpmc_queue & ) = delete;
+
+        bool try_push( const T &value ) override
+        {
+            cell *c;
+            std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for( ;; )
+            {
+                c = &cells_[pos & mask_];
+                std::size_t seq = c->sequence.load(std::memory_order_acquire);
+                std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)pos;
+                if( dif == 0 )
+                {
+                    if( enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+                        break;
+                }
+                else if( dif < 0 )
+                    return false;   // cheia
+                else
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+
+            c->data = value;
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop( T &value ) override
+        {
+            cell *c;
+            std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for( ;; )
+            {
+                c = &cells_[pos & mask_];
+                std::size_t seq = c->sequence.load(std::memory_order_acquire);
+                std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)(pos + 1);
+                if( dif == 0 )
+                {
+                    if( dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+                        break;
+                }
+                else if( dif < 0 )
+                    return false;   // vazia
+                else
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+
+            value = std::move(c->data);
+            c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Número aproximado de elementos armazenados
+        std::size_t size( void ) const override
+        {
+            std::size_t head = enqueue_pos_.load(std::memory_order_acquire);
+            std::size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+            return head > tail ? head - tail : 0;
+        }
+
+        std::size_t capacity( void ) const override { return mask_ + 1; }
+
+    private:
+        std::unique_ptr<cell[]> cells_;
+        std::size_t mask_;
+        char pad_ro_[cache_line_size];
+
+        std::atomic<std::size_t> enqueue_pos_{0};
+        char pad_enqueue_[cache_line_size];
+
+        std::atomic<std::size_t> dequeue_pos_{0};
+        char pad_dequeue_[cache_line_size];
+};
+
+#endif // MPMC_QUEUE_H
@@ -0,0 +1,383 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "bench_config.h"
+#include "cache_line.h"
+#include "channel.h"
+#include "payload_cache.h"
+#include "thread_pool.h"
+#include "thread_utils.h"
+
+template <typename P> class payload_handle;
+
+/// Contadores de um payload_pool
+struct payload_pool_stats
+{
+    std::size_t capacity = 0;       // objects preallocated in the slab
+    std::uint64_t acquired = 0;     // acquire() calls served by the slab
+    std::uint64_t remote_frees = 0; // slab objects released by a thread other than the acquirer
+    std::uint64_t heap_allocs = 0;  // acquire() calls that fell back to new (slab exhausted)
+    std::size_t thread_caches = 0;  // caches created (per thread; per stage on the thread_pool)
+
+    payload_pool_stats &operator+=( const payload_pool_stats &o )
+    {
+        capacity += o.capacity;
+        acquired += o.acquired;
+        remote_frees += o.remote_frees;
+        heap_allocs += o.heap_allocs;
+        thread_caches += o.thread_caches;
+        return *this;
+    }
+
+    // Counts accumulated since an earlier snapshot (capacity and caches as now)
+    payload_pool_stats since( const payload_pool_stats &earlier ) const
+    {
+        payload_pool_stats d = *this;
+        d.acquired -= earlier.acquired;
+        d.remote_frees -= earlier.remote_frees;
+        d.heap_allocs -= earlier.heap_allocs;
+        return d;
+    }
+};
+
+namespace payload_detail {
+
+// Caches of the caller. A stage task on the thread_pool may run on any
+// worker, so there the caches follow the stage: frames freed by consumers
+// go back to the producer stage, wherever it runs next
+inline thread_caches &current_thread_caches()
+{
+    if (thread_pool::current()) {
+        if (thread_base *stage = thread_base::running()) return stage->payload_caches();
+    }
+    static thread_local thread_caches caches;
+    return caches;
+}
+
+// Pools are matched by id, never by address (a new pool may reuse the address)
+inline std::uint64_t next_pool_id()
+{
+    static std::atomic<std::uint64_t> id{0};
+    return id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+}
+
+/**
+ * @brief Slab de payloads pré-alocados, entregues como payload_handle
+ *
+ * Todos os objetos são criados no construtor, num único bloco. Cada thread
+ * (ou, no thread_pool, cada estágio) tem um cache próprio: acquire() tira do cache local sem atômicos de
+ * leitura-modificação, e um objeto liberado volta para o cache de quem o
+ * adquiriu — direto, se for o mesmo thread, ou pela lista remote-free
+ * desse cache (pilha lock-free que o dono recolhe inteira com um exchange).
+ * No pipeline o produtor adquire e o consumidor libera, então os quadros
+ * circulam produtor -> fila -> consumidor -> remote-free -> produtor sem
+ * passar pelo alocador global.
+ *
+ * Com o slab esgotado acquire() recorre a new (stats().heap_allocs), e o
+ * objeto é apagado ao ser liberado. O cache de um thread que terminou é
+ * adotado pelo próximo thread que usar o pool.
+ *
+ * Os objetos são reutilizados sem serem reinicializados. Todos os handles
+ * devem ser liberados antes de o pool ser destruído.
+ *
+ * @tparam P tipo do payload (construtível por padrão)
+ */
+template <typename P>
+class payload_pool
+{
+    public:
+        struct cache;
+
+        struct node
+        {
+            P value;
+            std::atomic<int> refs{0};
+            /// Próximo na lista local ou remote-free
+            node *next = nullptr;
+            /// Cache que entregou o objeto; nullptr = alocado com new
+            cache *home = nullptr;
+            payload_pool *owner = nullptr;
+        };
+
+        struct cache : payload_detail::cache_base
+        {
+            /// Somente o thread dono
+            node *local = nullptr;
+            std::atomic<std::uint64_t> acquired{0};
+            std::atomic<std::uint64_t> local_frees{0};
+            char pad_[cache_line_size];
+
+            /// Liberados por outros threads
+            std::atomic<node *> remote{nullptr};
+            std::atomic<std::uint64_t> remote_frees{0};
+        };
+
+        /**
+         * @brief Cria o pool
+         *
+         * @param capacity número de objetos pré-alocados (mínimo 1)
+         */
+        explicit payload_pool( std::size_t capacity ) : id_(payload_detail::next_pool_id())
+        {
+            if( capacity == 0 ) capacity = 1;
+            nodes_.reset(new node[capacity]);
+            capacity_ = capacity;
+            for( std::size_t i = 0; i < capacity; i++ )
+                nodes_[i].owner = this;
+        }
+
+        ~payload_pool()
+        {
+            std::lock_guard<std::mutex> lk(caches_mtx_);
+            for( auto &c : caches_ )
+                c->retired.store(true, std::memory_order_release);
+        }
+
+        payload_pool( const payload_pool & ) = delete;
+        payload_pool &operator=( const payload_pool & ) = delete;
+
+        /**
+         * @brief Obtém um payload livre (referência única)
+         *
+         * Nunca falha: com o slab esgotado o objeto vem de new.
+         */
+        payload_handle<P> acquire( void )
+        {
+            cache *c = local_cache();
+            node *n = c->local;
+            if( !n )
+                n = c->remote.exchange(nullptr, std::memory_order_acquire);
+
+            if( n )
+                c->local = n->next;
+            else
+            {
+                std::size_t i = fresh_.fetch_add(1, std::memory_order_relaxed);
+                if( i < capacity_ )
+                    n = &nodes_[i];
+                else
+                {
+                    n = new node;
+                    n->owner = this;
+                    heap_allocs_.fetch_add(1, std::memory_order_relaxed);
+                    n->refs.store(1, std::memory_order_relaxed);
+                    return payload_handle<P>(n);
+                }
+            }
+
+            n->home = c;
+            c->acquired.store(c->acquired.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            n->refs.store(1, std::memory_order_relaxed);
+            return payload_handle<P>(n);
+        }
+
+        std::size_t capacity( void ) const { return capacity_; }
+
+        /// Objetos do slab fora de uso no momento (aproximado)
+        std::size_t available( void ) const
+        {
+            payload_pool_stats s = stats();
+            std::uint64_t in_use = s.acquired - s.remote_frees - local_frees();
+            return capacity_ - (std::size_t)in_use;
+        }
+
+        /// Quantas vezes acquire() precisou de new
+        std::uint64_t overflow( void ) const { return heap_allocs_.load(std::memory_order_relaxed); }
+
+        payload_pool_stats stats( void ) const
+        {
+            payload_pool_stats s;
+            s.capacity = capacity_;
+            s.heap_allocs = overflow();
+
+            std::lock_guard<std::mutex> lk(caches_mtx_);
+            s.thread_caches = caches_.size();
+            for( const auto &c : caches_ )
+            {
+                s.acquired += c->acquired.load(std::memory_order_relaxed);
+                s.remote_frees += c->remote_frees.load(std::memory_order_relaxed);
+            }
+            return s;
+        }
+
+    private:
+        friend class payload_handle<P>;
+
+        /// Chamado pelo último handle de n
+        void recycle( node *n )
+        {
+            cache *home = n->home;
+            if( !home )
+            {
+                delete n;
+                return;
+            }
+
+            if( home == find_cache() )
+            {
+                n->next = home->local;
+                home->local = n;
+                home->local_frees.store(home->local_frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+
+            node *head = home->remote.load(std::memory_order_relaxed);
+            do
+            {
+                n->next = head;
+            } while( !home->remote.compare_exchange_weak(head, n, std::memory_order_release, std::memory_order_relaxed) );
+            home->remote_frees.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Cache do thread atual, ou nullptr se ele ainda não usou o pool
+        cache *find_cache( void ) const
+        {
+            for( const auto &e : payload_detail::current_thread_caches().entries )
+            {
+                if( e.pool == id_ ) return static_cast<cache *>(e.cache.get());
+            }
+            return nullptr;
+        }
+
+        cache *local_cache( void )
+        {
+            cache *c = find_cache();
+            return c ? c : register_thread();
+        }
+
+        /// Primeiro uso do pool pelo thread: adota um cache órfão ou cria um
+        cache *register_thread( void )
+        {
+            auto &entries = payload_detail::current_thread_caches().entries;
+            for( std::size_t i = 0; i < entries.size(); )
+            {
+                if( entries[i].cache->retired.load(std::memory_order_acquire) )
+                    entries.erase(entries.begin() + i);
+                else
+                    i++;
+            }
+
+            std::lock_guard<std::mutex> lk(caches_mtx_);
+            std::shared_ptr<cache> mine;
+            for( auto &c : caches_ )
+            {
+                bool orphan = false;
+                if( c->owned.compare_exchange_strong(orphan, true, std::memory_order_acquire) )
+                {
+                    mine = c;
+                    break;
+                }
+            }
+            if( !mine )
+            {
+                mine = std::make_shared<cache>();
+                caches_.push_back(mine);
+            }
+
+            payload_detail::thread_entry e;
+            e.pool = id_;
+            e.cache = mine;
+            entries.push_back(e);
+            return mine.get();
+        }
+
+        std::uint64_t local_frees( void ) const
+        {
+            std::uint64_t n = 0;
+            std::lock_guard<std::mutex> lk(caches_mtx_);
+            for( const auto &c : caches_ )
+                n += c->local_frees.load(std::memory_order_relaxed);
+            return n;
+        }
+
+        const std::uint64_t id_;
+
+        /// Slab: todos os objetos, entregues uma vez em ordem e depois reciclados pelos caches
+        std::unique_ptr<node[]> nodes_;
+        std::size_t capacity_ = 0;
+        std::atomic<std::size_t> fresh_{0};
+
+        std::atomic<std::uint64_t> heap_allocs_{0};
+
+        mutable std::mutex caches_mtx_;
+        std::vector<std::shared_ptr<cache>> caches_;
+};
+
+/**
+ * @brief Referência contada a um payload de um payload_pool
+ *
+ * Cópias só incrementam a contagem: nas filas do pipeline trafega apenas
+ * o ponteiro. O último handle devolve o objeto ao pool. O payload é
+ * compartilhado entre todos os handles (fan-out): consumidores não
+ * devem alterá-lo.
+ *
+ * @tparam P tipo do payload
+ */
+template <typename P>
+class payload_handle
+{
+    typedef typename payload_pool<P>::node node;
+
+    node *node_ = nullptr;
+
+    friend class payload_pool<P>;
+    explicit payload_handle( node *n ) : node_(n) {}
+
+    public:
+        payload_handle( void ) = default;
+
+        payload_handle( const payload_handle &o ) : node_(o.node_)
+        {
+            if( node_ ) node_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        payload_handle( payload_handle &&o ) noexcept : node_(o.node_)
+        {
+            o.node_ = nullptr;
+        }
+
+        payload_handle &operator=( payload_handle o ) noexcept
+        {
+            std::swap(node_, o.node_);
+            return *this;
+        }
+
+        ~payload_handle() { reset(); }
+
+        /// Solta a referência; devolve o payload ao pool se era a última
+        void reset( void )
+        {
+            if( node_ && node_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1 )
+                node_->owner->recycle(node_);
+            node_ = nullptr;
+        }
+
+        P *get( void ) const { return node_ ? &node_->value : nullptr; }
+        P &operator*( void ) const { return node_->value; }
+        P *operator->( void ) const { return &node_->value; }
+        explicit operator bool( void ) const { return node_ != nullptr; }
+
+        /// Número de handles para o mesmo payload (aproximado)
+        int use_count( void ) const { return node_ ? node_->refs.load(std::memory_order_relaxed) : 0; }
+};
+
+// Slab size for a producer stage used on its own: one full queue plus items
+// in flight in consumer batches and in the producer itself
+inline std::size_t payload_capacity_of(const BenchConfig *cfg)
+{
+    std::size_t queue = queue_capacity_of(cfg);
+    if (queue == 0) queue = default_queue_capacity;
+    return 2 * queue + 2 * batch_size_of(cfg);
+}
+
+#endif // PAYLOAD_H
@@ -0,0 +1,44 @@
+#ifndef PAYLOAD_CACHE_H
+#define PAYLOAD_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Owner side of the payload_pool caches (see payload.h), split out so that
+// thread_base can own the caches of a stage running on the thread_pool
+
+namespace payload_detail {
+
+// Cache of one pool, owned by a thread or a pooled stage (the part that
+// does not depend on P)
+struct cache_base
+{
+    // false once the owner (thread or stage) is gone: another thread may adopt the cache
+    std::atomic<bool> owned{true};
+    // set when the pool is destroyed, so thread entries can be pruned
+    std::atomic<bool> retired{false};
+    virtual ~cache_base() = default;
+};
+
+struct thread_entry
+{
+    std::uint64_t pool;
+    std::shared_ptr<cache_base> cache;
+};
+
+// Caches of one owner, one per pool it used
+struct thread_caches
+{
+    std::vector<thread_entry> entries;
+
+    ~thread_caches()
+    {
+        for (auto &e : entries) e.cache->owned.store(false, std::memory_order_release);
+    }
+};
+
+}
+
+#endif // PAYLOAD_CACHE_H
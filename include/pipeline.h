@@ -2,53 +2,209 @@
 #include "source_threads.h"
 #include "process_thread.h"
 #include "source_process_threads.h"
+#include "pipeline_builder.h"
+#include "thread_pool.h"
+#include "latency_histogram.h"
+#include <chrono>
+#include <memory>
+#include <vector>
 
 #ifndef PIPELINE_H
 #define PIPELINE_H
 
+/// Como Pipeline::stop() encerra os estágios
+enum class stop_mode {
+    cancel,   ///< interrompe esperas e trabalho em andamento; itens em fila ficam sem processar
+    drain     ///< para as sources e esvazia as filas, camada a camada, antes de parar
+};
+
+/// Lê "cancel" ou "drain"; false se desconhecido
+bool stop_mode_from_string( const std::string &s, stop_mode &mode );
+const char *stop_mode_name( stop_mode mode );
+
+/// Tempo máximo de stop_mode::drain antes de cancelar o que restou
+constexpr std::chrono::milliseconds default_drain_timeout{5000};
+
+/// Resultado de Pipeline::stop()
+struct shutdown_report {
+    std::chrono::nanoseconds latency{0};   ///< da chamada até a última thread terminar
+    std::chrono::nanoseconds drain{0};     ///< parte gasta esvaziando as filas (drain)
+    std::size_t discarded = 0;             ///< itens que ficaram nas filas
+    bool drain_timed_out = false;          ///< o drain estourou o prazo e foi cancelado
+};
+
+/**
+ * @brief Grafo de estágios em execução
+ *
+ * Construído a partir de um PipelineBuilder: a topologia padrão
+ * (BenchConfig::producers/consumers), a de BenchConfig::pipeline_file
+ * ou uma montada em código.
+ */
 class Pipeline
 {
-    source_A source_Captura;
-    process_A process_Captura;
-    source_B process_cap_gen;
-    process_B process_gen;
+    /// Executor compartilhado (BenchConfig::executor == "pool"); nullptr = threads dedicadas.
+    /// Declarado primeiro para ser destruído depois dos estágios.
+    std::unique_ptr<thread_pool> pool;
+
+    /// Latências por estágio e fim a fim, registradas pelos estágios
+    pipeline_metrics metrics_;
+
+    /// Slabs dos quadros em trânsito, por tipo de item, dimensionados pelas filas.
+    /// Declarados antes das filas e estágios para serem destruídos depois deles.
+    std::unique_ptr<payload_pool<frame_A>> frames_A;
+    std::unique_ptr<payload_pool<frame_B>> frames_B;
+
+    /// Filas de entrada de cada estágio consumidor, por tipo de item
+    std::vector<std::unique_ptr<channel<item_A>>> queues_A;
+    std::vector<std::unique_ptr<channel<item_B>>> queues_B;
+
+    /// Instâncias, por tipo
+    std::vector<std::unique_ptr<source_A>> sources_A;
+    std::vector<std::unique_ptr<process_A>> processes_A;
+    std::vector<std::unique_ptr<source_B>> sources_B;
+    std::vector<std::unique_ptr<process_B>> processes_B;
+
+    /// Todas as instâncias, na ordem de declaração dos estágios (start/stop)
+    std::vector<thread_base *> stages;
 
     public:
-        // Pipeline now accepts an optional BenchConfig pointer so workers can access config without globals
+        /**
+         * @brief Pipeline configurado por BenchConfig
+         *
+         * Usa BenchConfig::pipeline_file quando definido, senão a
+         * topologia padrão (PipelineBuilder::standard).
+         *
+         * @throw std::invalid_argument arquivo de topologia inválido
+         */
         Pipeline( BenchConfig *cfg = nullptr ) :
-            source_Captura(),
-            process_Captura(&source_Captura, cfg),
-            process_cap_gen(&source_Captura),
-            process_gen(&process_cap_gen, cfg) {}
-        
+            Pipeline( (cfg && !cfg->pipeline_file.empty())
+                        ? PipelineBuilder::from_file(cfg->pipeline_file, cfg)
+                        : PipelineBuilder::standard(cfg) )
+        {
+        }
+
+        /**
+         * @brief Instancia o grafo descrito (estágios parados)
+         *
+         * @throw std::invalid_argument se spec.validate() falhar
+         */
+        explicit Pipeline( const PipelineBuilder &spec );
+
         ~Pipeline()
         {
             stop();
         }
 
+        Pipeline( const Pipeline & ) = delete;
+        Pipeline &operator=( const Pipeline & ) = delete;
+
         void start( void )
         {
-            /// Inicia a thread de source
-            source_Captura.start();
+            for( auto *stage : stages )
+                stage->start(pool.get());
+        }
+
+        /**
+         * @brief Encerra os estágios
+         *
+         * Com cancel todos são sinalizados de uma vez (stop_token e
+         * filas acordadas) e só então aguardados, então a latência é a
+         * do estágio mais lento a sair, não a soma. Com drain (que retoma
+         * um pipeline pausado) as sources terminam o ciclo atual e cada camada só para depois que suas
+         * filas de entrada esvaziam; estourado drain_timeout, o restante
+         * é cancelado.
+         *
+         * @return latência do encerramento e itens deixados nas filas
+         */
+        shutdown_report stop( stop_mode mode = stop_mode::cancel,
+                              std::chrono::milliseconds drain_timeout = default_drain_timeout );
+
+        /**
+         * @brief Estaciona todos os estágios, sem encerrar as threads
+         *
+         * Pede a pausa a todos antes de esperar, então o tempo é o do
+         * estágio mais lento a terminar o run() atual, não a soma.
+         */
+        void pause( void )
+        {
+            for( auto *stage : stages )
+                stage->request_pause();
+            for( auto *stage : stages )
+                stage->wait_paused();
+        }
 
-            /// Inicia thread de processamento, para Source_A
-            process_Captura.start();
+        /**
+         * @brief Volta ao estado de recém-construído, com os estágios pausados ou parados
+         *
+         * Esvazia as filas (os quadros voltam aos slabs), reinicia o estado
+         * de cada estágio e zera as latências. Contadores cumulativos
+         * (frame_stats(), backpressure()) não são zerados.
+         */
+        void reset( void );
 
-            /// Inicia thread de processamento e geração
-            process_cap_gen.start();
-            
-            /// Inicia thread de processamento, para source_B
-            process_gen.start();
+        /**
+         * @brief Retoma os estágios pausados, nas mesmas threads
+         */
+        void resume( void )
+        {
+            for( auto *stage : stages )
+                stage->resume();
         }
 
-        void stop( void )
+        /**
+         * @brief Latências registradas desde a construção
+         *
+         * Leia após stop() para um retrato consistente.
+         */
+        const pipeline_metrics &metrics( void ) const { return metrics_; }
+
+        /**
+         * @brief Zera as latências (ex.: na abertura da janela de medição)
+         *
+         * Pode ser chamada com os estágios em execução.
+         */
+        void reset_metrics( void ) { metrics_.reset(); }
+
+        /**
+         * @brief Contadores de alocação dos quadros (frame_A + frame_B)
+         *
+         * Leia após stop(). heap_allocs > 0 indica slab pequeno demais.
+         */
+        payload_pool_stats frame_stats( void ) const
+        {
+            payload_pool_stats s = frames_A->stats();
+            s += frames_B->stats();
+            return s;
+        }
+
+        /**
+         * @brief Bloqueios e descartes por fila cheia, somados em todas as filas
+         *
+         * Leia após stop().
+         */
+        backpressure_stats backpressure( void ) const
+        {
+            backpressure_stats s;
+            for( const auto &q : queues_A ) s += q->backpressure();
+            for( const auto &q : queues_B ) s += q->backpressure();
+            return s;
+        }
+
+        /// Total de instâncias de estágios
+        std::size_t instance_count( void ) const { return stages.size(); }
+
+        /**
+         * @brief CPUs permitidas a cada instância, lidas pela própria thread (thread_base::running_cpus)
+         *
+         * Na ordem de declaração dos estágios, como PipelineBuilder::placement() achatado.
+         */
+        std::vector<std::vector<int>> running_cpus( void ) const
         {
-            //Envia sinal parar as threads (stop() agora também faz join() internamente)
-            source_Captura.stop();
-            process_Captura.stop();
-            process_cap_gen.stop();
-            process_gen.stop();
+            std::vector<std::vector<int>> cpus;
+            for( auto *stage : stages )
+                cpus.push_back(stage->running_cpus());
+            return cpus;
         }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,151 @@
+#ifndef PIPELINE_BUILDER_H
+#define PIPELINE_BUILDER_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_config.h"
+#include "cpu_affinity.h"
+#include "wait_strategy.h"
+#include "backpressure.h"
+
+class Pipeline;
+
+/// Tipos de estágio disponíveis no grafo
+enum class stage_kind { source_A, process_A, source_B, process_B };
+
+/**
+ * @brief Descrição de um grafo de estágios, usada para construir um Pipeline
+ *
+ * Cada estágio tem um nome, um tipo e um número de instâncias. Uma aresta
+ * from -> to entrega cada item produzido por from ao estágio to; as arestas
+ * são tipadas (source_A produz item_A, lido por process_A e
+ * source_B; source_B produz item_B, lido por process_B).
+ *
+ * Cada estágio consumidor tem uma única fila de entrada, compartilhada pelas
+ * suas instâncias (cada item é processado por uma delas) e alimentada por
+ * todas as arestas que chegam nele (fan-in). Um produtor com várias arestas
+ * entrega cada item em todas (fan-out). A fila é SPSC quando há um único
+ * produtor e um único consumidor, e MPMC caso contrário.
+ *
+ * Formato do arquivo (uma diretiva por linha, '#' inicia comentário):
+ *
+ *     stage <nome> <source_A|process_A|source_B|process_B> [instâncias]
+ *     edge <de> <para>
+ */
+class PipelineBuilder
+{
+    public:
+        struct stage_spec
+        {
+            std::string name;
+            stage_kind kind;
+            int instances;
+        };
+
+        struct edge_spec
+        {
+            std::string from;
+            std::string to;
+        };
+
+        explicit PipelineBuilder( BenchConfig *cfg = nullptr ) : cfg_(cfg) {}
+
+        /**
+         * @brief Declara um estágio
+         *
+         * @param name nome único, usado nas arestas
+         * @param kind tipo do estágio
+         * @param instances quantidade de instâncias (>= 1)
+         */
+        PipelineBuilder &stage( const std::string &name, stage_kind kind, int instances = 1 );
+        PipelineBuilder &stage( const std::string &name, const std::string &kind, int instances = 1 );
+
+        /**
+         * @brief Liga a saída de from à entrada de to
+         */
+        PipelineBuilder &connect( const std::string &from, const std::string &to );
+
+        /**
+         * @brief Verifica o grafo
+         *
+         * @throw std::invalid_argument nomes repetidos ou desconhecidos, tipos
+         *        incompatíveis ou consumidor sem entrada
+         */
+        void validate( void ) const;
+
+        /**
+         * @brief Cria o pipeline (ainda parado)
+         *
+         * @throw std::invalid_argument se validate() falhar
+         */
+        std::unique_ptr<Pipeline> build( void ) const;
+
+        /**
+         * @brief CPUs de cada instância (BenchConfig::affinity e ::stage_affinity)
+         *
+         * Indexado como stages(): [estágio][instância]; lista vazia = thread
+         * não fixada. Em "auto" os estágios são percorridos ao longo das
+         * arestas e cada instância recebe a próxima CPU de
+         * topo.placement_order(), de modo que produtor e consumidor vizinhos
+         * fiquem em núcleos irmãos. stage_affinity sobrepõe o automático.
+         *
+         * @throw std::invalid_argument modo desconhecido, lista de CPUs
+         *        inválida ou estágio inexistente
+         */
+        std::vector<std::vector<std::vector<int>>> placement( const cpu_topology &topo ) const;
+
+        /**
+         * @brief Estratégia de espera de cada estágio (BenchConfig::wait_strategy e ::channel_waits)
+         *
+         * Indexado como stages(). Vale para a fila de entrada de um
+         * consumidor e para o canal de read() de uma source.
+         *
+         * @throw std::invalid_argument estratégia desconhecida ou estágio inexistente
+         */
+        std::vector<wait_strategy> wait_strategies( void ) const;
+
+        /**
+         * @brief Política de fila cheia de cada aresta (BenchConfig::backpressure e ::edge_backpressure)
+         *
+         * Indexado como edges(). A fila de um consumidor com alguma aresta
+         * drop_oldest é sempre MPMC, para que o produtor possa remover itens.
+         *
+         * @throw std::invalid_argument política desconhecida ou aresta inexistente
+         */
+        std::vector<overflow_policy> edge_policies( void ) const;
+
+        /**
+         * @brief Topologia padrão: source_A -> process_A e source_A -> source_B -> process_B
+         *
+         * source_B e process_B usam BenchConfig::producers e ::consumers instâncias.
+         */
+        static PipelineBuilder standard( BenchConfig *cfg );
+
+        /**
+         * @brief Lê a topologia de um arquivo
+         *
+         * @throw std::invalid_argument arquivo inexistente ou linha inválida
+         */
+        static PipelineBuilder from_file( const std::string &path, BenchConfig *cfg );
+        static PipelineBuilder parse( std::istream &in, BenchConfig *cfg );
+
+        /// Tipo correspondente ao nome ("source_A", ...); false se desconhecido
+        static bool kind_from_string( const std::string &s, stage_kind &kind );
+
+        const std::vector<stage_spec> &stages( void ) const { return stages_; }
+        const std::vector<edge_spec> &edges( void ) const { return edges_; }
+        BenchConfig *config( void ) const { return cfg_; }
+
+        /// Índice do estágio com esse nome, ou -1
+        int find( const std::string &name ) const;
+
+    private:
+        BenchConfig *cfg_;
+        std::vector<stage_spec> stages_;
+        std::vector<edge_spec> edges_;
+};
+
+#endif // PIPELINE_BUILDER_H
@@ -3,6 +3,9 @@
 #include "source_process_threads.h"
 #include "bench_config.h"
 #include "bench_metrics.h"
+#include "latency_histogram.h"
+#include "workload.h"
+#include <vector>
 
 #ifndef PROCESS_THREADS_H
 #define PROCESS_THREADS_H
@@ -15,21 +18,37 @@
  */
 class process_A : public thread_base
 {
-    /// Ponteiro para uma classe de source
-    source_A *cap;
+    /// Fila de entrada (inscrita na source ou compartilhada)
+    channel<item_A> *in;
+
+    /// Lote lido da fila (BenchConfig::batch_size)
+    std::vector<item_A> batch;
 
     /// Optional pointer to config (no global external dependency)
     BenchConfig *cfg;
 
+    /// Latências (opcional, definido pelo Pipeline)
+    pipeline_metrics *metrics = nullptr;
+
+    /// Trabalho simulado do estágio (BenchConfig::workload)
+    workload work;
+
+    /// Soma dos bytes dos quadros lidos: o payload é de fato percorrido
+    unsigned checksum_ = 0;
+
     /**
      * @brief Inicializa a classe
      * 
-     * @param cap_ ponteiro para classe source
+     * @param in_ fila de entrada
+     * @param cfg_ configuração opcional
      */
-    void init( source_A *cap_, BenchConfig *cfg_ = nullptr )
+    void init( channel<item_A> *in_, BenchConfig *cfg_ = nullptr )
     {
-        cap = cap_;
+        in = in_;
         cfg = cfg_;
+        work = workload::for_stage(cfg_, "pcA");
+        work.set_stop_token(get_stop_token());
+        batch.resize(batch_size_of(cfg_));
     }
 
     public:
@@ -49,30 +68,58 @@ class process_A : public thread_base
          */
         process_A( source_A *cap_ ) : thread_base()
         { 
-            this->init(cap_, nullptr);
+            this->init(cap_ ? cap_->subscribe() : NULL, nullptr);
         };
 
         process_A( source_A *cap_, BenchConfig *cfg_ ) : thread_base()
         {
-            this->init(cap_, cfg_);
+            this->init(cap_ ? cap_->subscribe() : NULL, cfg_);
+        };
+
+        /**
+         * @brief Contrutor da classe process_A
+         * 
+         * @param in_ fila de entrada, possivelmente compartilhada com outras instâncias
+         * @param cfg_ configuração opcional
+         */
+        process_A( channel<item_A> *in_, BenchConfig *cfg_ ) : thread_base()
+        {
+            this->init(in_, cfg_);
         };
 
         /**
          * @brief Função principal
          * 
          * Efetua o processamento das informações do buffer,
-         * de modo continuo. Usa condition_variable para
-         * sincronizar com a source.
+         * de modo continuo. Consome a fila de entrada,
+         * processando cada item exatamente uma vez.
          * 
          */
         void run( void ) override;
 
         /**
-         * @brief Efetua o processamento do dado lido
+         * @brief Efetua o processamento de um quadro lido
+         * 
+         * @param frame quadro compartilhado com os demais consumidores (somente leitura)
+         */
+        void process_buffer( const frame_A &frame );
+
+        /**
+         * @brief Define onde registrar as latências do estágio
          * 
-         * @param buffer ponteiro para o dado
+         * Deve ser chamada antes de start(); nullptr desativa o registro.
+         * 
+         * @param m métricas do pipeline, devem viver mais que o estágio
          */
-        void process_buffer( int *buffer );
+        void set_metrics( pipeline_metrics *m ) { metrics = m; }
+
+        /**
+         * @brief Solta os itens retidos no lote (com o estágio pausado ou parado)
+         */
+        void reset_state( void ) override
+        {
+            for( auto &item : batch ) item.reset();
+        }
 };
 
 
@@ -84,21 +131,37 @@ class process_A : public thread_base
  */
 class process_B : public thread_base
 {
-    /// Ponteiro para uma classe de source
-    source_B *cap;
+    /// Fila de entrada (inscrita na source ou compartilhada)
+    channel<item_B> *in;
+
+    /// Lote lido da fila (BenchConfig::batch_size)
+    std::vector<item_B> batch;
 
     /// Optional pointer to config (no global external dependency)
     BenchConfig *cfg;
 
+    /// Latências (opcional, definido pelo Pipeline)
+    pipeline_metrics *metrics = nullptr;
+
+    /// Trabalho simulado do estágio (BenchConfig::workload)
+    workload work;
+
+    /// Soma dos bytes dos quadros lidos: o payload é de fato percorrido
+    unsigned checksum_ = 0;
+
     /**
      * @brief Inicializa a classe
      * 
-     * @param cap_ ponteiro para classe source
+     * @param in_ fila de entrada
+     * @param cfg_ configuração opcional
      */
-    void init( source_B *cap_, BenchConfig *cfg_ = nullptr )
+    void init( channel<item_B> *in_, BenchConfig *cfg_ = nullptr )
     {
-        cap = cap_;
+        in = in_;
         cfg = cfg_;
+        work = workload::for_stage(cfg_, "pcB");
+        work.set_stop_token(get_stop_token());
+        batch.resize(batch_size_of(cfg_));
     }
 
     public:
@@ -118,30 +181,58 @@ class process_B : public thread_base
          */
         process_B( source_B *cap_ ) : thread_base()
         { 
-            this->init(cap_, nullptr);
+            this->init(cap_ ? cap_->subscribe() : NULL, nullptr);
         };
 
         process_B( source_B *cap_, BenchConfig *cfg_ ) : thread_base()
         {
-            this->init(cap_, cfg_);
+            this->init(cap_ ? cap_->subscribe() : NULL, cfg_);
+        };
+
+        /**
+         * @brief Contrutor da classe process_B
+         * 
+         * @param in_ fila de entrada, possivelmente compartilhada com outras instâncias
+         * @param cfg_ configuração opcional
+         */
+        process_B( channel<item_B> *in_, BenchConfig *cfg_ ) : thread_base()
+        {
+            this->init(in_, cfg_);
         };
 
         /**
          * @brief Função principal
          * 
          * Efetua o processamento das informações do buffer,
-         * de modo continuo. Usa condition_variable para
-         * sincronizar com a source.
+         * de modo continuo. Consome a fila de entrada,
+         * processando cada item exatamente uma vez.
          * 
          */
         void run( void ) override;
 
         /**
-         * @brief Efetua o processamento do dado lido
+         * @brief Efetua o processamento de um quadro lido
+         * 
+         * @param frame quadro compartilhado com os demais consumidores (somente leitura)
+         */
+        void process_buffer( const frame_B &frame );
+
+        /**
+         * @brief Define onde registrar as latências do estágio
          * 
-         * @param buffer ponteiro para o dado
+         * Deve ser chamada antes de start(); nullptr desativa o registro.
+         * 
+         * @param m métricas do pipeline, devem viver mais que o estágio
          */
-        void process_buffer( int *buffer );
+        void set_metrics( pipeline_metrics *m ) { metrics = m; }
+
+        /**
+         * @brief Solta os itens retidos no lote (com o estágio pausado ou parado)
+         */
+        void reset_state( void ) override
+        {
+            for( auto &item : batch ) item.reset();
+        }
 };
 
 #endif
\ No newline at end of file
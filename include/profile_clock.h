@@ -0,0 +1,62 @@
+#ifndef PROFILE_CLOCK_H
+#define PROFILE_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__linux__)
+#include <x86intrin.h>
+#define PROFILE_CLOCK_HAS_TSC 1
+#else
+#define PROFILE_CLOCK_HAS_TSC 0
+#endif
+
+enum class profile_clock_source { steady, tsc };
+
+// Timestamp source of the profiler. now() returns raw ticks, cheap enough
+// for the hot path; to_ns() converts them when the writer drains events.
+// steady (default): std::chrono::steady_clock, ticks are nanoseconds.
+// tsc: rdtsc calibrated against steady_clock (x86 Linux, invariant TSC only).
+class profile_clock {
+public:
+    static long long now()
+    {
+#if PROFILE_CLOCK_HAS_TSC
+        if (tsc_.load(std::memory_order_relaxed))
+            return (long long)__rdtsc();
+#endif
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Ticks of now() to steady_clock nanoseconds
+    static long long to_ns(long long ticks);
+
+    // Select the source; tsc calibrates first (~20ms). Returns false, keeping
+    // steady, when the CPU has no invariant TSC. Change it while no events
+    // are pending (ProfilePrinter::set_clock() takes care of that).
+    static bool select(profile_clock_source source);
+
+    static profile_clock_source source()
+    {
+        return tsc_.load(std::memory_order_relaxed) ? profile_clock_source::tsc : profile_clock_source::steady;
+    }
+
+    // Whether this build/CPU can use the tsc source
+    static bool tsc_available();
+
+private:
+    // steady ns = base_ns + (ticks - base_ticks) * ns_per_tick. Immutable once
+    // published, so to_ns() on any thread sees one consistent set
+    struct calibration {
+        long long base_ticks;
+        long long base_ns;
+        double ns_per_tick;
+    };
+
+    // The calibration in use, null while the source is steady. select()
+    // publishes a new one; old ones stay alive for readers still holding them
+    static std::atomic<const calibration *> tsc_;
+};
+
+#endif // PROFILE_CLOCK_H
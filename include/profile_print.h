@@ -1,20 +1,99 @@
-
 #ifndef PROFILE_PRINT
 #define PROFILE_PRINT
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <fstream>
+#include <ostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include "profile_clock.h"
+#include "profile_trace.h"
+#include "profile_zones.h"
+
+// One profile record as stored in the per-thread rings
+struct profile_event {
+    const char *name = nullptr;   // must outlive the drain (string literals); null for registered zones
+    zone_id zone = zone_id::count;   // registered zone (name looked up by the writer)
+    long long t = 0;              // zones: profile_clock ticks (converted at drain); lines: as given
+    int status = 0;               // 0/1: single line; profile_zone_begin/end: expanded by the writer
+};
+
+// start()/stop() store a single event that the writer expands into the
+// two lines (0,1) / (1,0) of the CSV timeline
+constexpr int profile_zone_begin = 2;
+constexpr int profile_zone_end = 3;
+
+// Which registered zones (zone_id) get recorded, for long runs where every
+// zone would be too much output. Named zones and write_line() are not
+// affected. Zones are admitted or skipped as a whole (start and stop).
+struct profile_sampling {
+    unsigned sample_every = 1;    // per thread and zone, record 1 in N
+    long long capture_ms = 0;     // > 0: record only during capture_ms after each trigger_capture()
+    unsigned budget_per_s = 0;    // > 0: at most this many zones per second, all threads together
+};
+
+// Zones skipped by profile_sampling, per reason
+struct profile_sampling_stats {
+    unsigned long long sampled_out = 0;
+    unsigned long long outside_capture = 0;
+    unsigned long long over_budget = 0;
+};
+
+// Running totals of one registered zone, over the time aggregation was on
+struct zone_summary {
+    zone_id zone = zone_id::count;
+    unsigned threads = 0;                // threads that recorded it (instances of a stage)
+    unsigned long long count = 0;
+    double total_ns = 0.0;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+    double mean_ns() const { return count ? total_ns / (double)count : 0.0; }
+};
+
+// Per-zone aggregates and the time they cover
+struct zone_report {
+    double elapsed_ns = 0.0;             // time aggregation was on
+    std::vector<zone_summary> zones;     // zones seen at least once, in zone_id order
+};
+
+// Writes a zone_report as a utilization table (util = zone time / (elapsed *
+// threads), i.e. per instance), then each stage with its busy and input-wait
+// share, naming the stage with the highest per-instance busy share as the
+// bottleneck
+void write_zone_report(std::ostream &out, const zone_report &report);
+
+// Output encoding: text CSV (thread,time,status) or the binary trace of
+// profile_trace.h (see tools/profile_convert for CSV/Chrome conversion)
+enum class profile_format { csv, binary };
 
-// Small thread-safe singleton that manages the profile output file stream
+// Events each thread can buffer before the writer drains them; when the
+// ring is full new events are dropped (and counted) instead of blocking
+constexpr std::size_t profile_ring_capacity = 1 << 14;
+
+// Thread-safe singleton that manages the profile output file stream.
+// Recording threads only touch a thread-local lock-free ring; a background
+// writer drains all rings and writes them to the file in batches.
 class ProfilePrinter {
 public:
+    struct thread_buffer;
+
     static ProfilePrinter& get();
 
-    // Open (or create) a file for appending profile events; returns false on error
+    // Open (or create) a file for appending profile events; returns false on error.
+    // Paths ending in ".csv" are written as text, anything else as binary trace.
     bool open_file(const std::string &path);
+    bool open_file(const std::string &path, profile_format format);
+
+    // Format open_file(path) picks for a path
+    static profile_format format_for(const std::string &path);
 
-    // Set an already-open file stream (for testing)
+    // Set an already-open file stream, written as CSV (for testing)
     void set_stream(std::ofstream &&stream);
 
     void write_line(const char *name, long long t, int status);
@@ -22,6 +101,45 @@ public:
     void start(const char *name);
     void stop(const char *name);
 
+    // Registered zones: no string is touched on the recording thread
+    void start(zone_id zone);
+    void stop(zone_id zone);
+
+    // Timestamp source of start()/stop(); false if unavailable (steady is kept).
+    // Select it before recording starts.
+    bool set_clock(profile_clock_source source);
+
+    // Write everything recorded so far (by any thread) to the file
+    void flush();
+
+    // Events lost because a thread's ring was full
+    unsigned long long dropped_events() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Sampling of registered zones; the default records every zone
+    void set_sampling(const profile_sampling &sampling);
+    profile_sampling sampling() const;
+
+    // Opens a capture window of capture_ms, starting at the next zone
+    // recorded
+    void trigger_capture() { capture_pending_.store(true, std::memory_order_relaxed); }
+
+    // trigger_capture() for signal handlers: only sets a lock-free flag
+    // (get() is not async-signal-safe), which the writer thread turns into
+    // trigger_capture() on its next drain
+    static void trigger_capture_from_signal() { capture_signalled_.store(true, std::memory_order_relaxed); }
+
+    profile_sampling_stats sampling_stats() const;
+
+    // Per-zone aggregates of registered zones (count, total, min/max),
+    // kept by the recording threads while on, whether or not a file is open
+    // and regardless of sampling. Off by default; turning it on and off
+    // accumulates, e.g. over the measured windows only
+    void set_aggregation(bool on);
+    zone_report zone_stats();
+
+    // Clears the aggregates; call while no zone is running
+    void reset_zone_stats();
+
     // Mute/unmute output (useful for unit tests)
     void mute();
     void unmute();
@@ -30,14 +148,93 @@ private:
     ProfilePrinter();
     ~ProfilePrinter();
 
-    std::mutex mtx_;
+    bool recording() const;
+    bool admit(thread_buffer *buf, zone_id zone, long long ticks);
+    void fold_retired(const thread_buffer &buf);
+    void record(const profile_event &ev);
+    thread_buffer *local_buffer();
+    void writer_main();
+    void drain_locked();
+    void write_events(unsigned thread, const profile_event *events, std::size_t count);
+    void close_locked();
+
+    // Protects log_file_ and the drain (single consumer of every ring)
+    std::mutex file_mtx_;
     std::ofstream log_file_;
-    bool muted_;
+    profile_format format_ = profile_format::csv;
+    trace_encoder encoder_;
+    std::vector<profile_event> scratch_;
+    std::atomic<bool> has_output_{false};
+    std::atomic<bool> muted_{false};
+    std::atomic<unsigned long long> dropped_{0};
+
+    // profile_sampling, read by recording threads
+    std::atomic<unsigned> sample_every_{1};
+    std::atomic<long long> capture_ns_{0};
+    std::atomic<unsigned> budget_per_s_{0};
+    std::atomic<bool> capture_pending_{false};
+    static std::atomic<bool> capture_signalled_;
+    std::atomic<long long> capture_until_ns_{0};
+    std::atomic<long long> budget_second_{-1};
+    std::atomic<unsigned> budget_used_{0};
+    std::atomic<unsigned long long> sampled_out_{0};
+    std::atomic<unsigned long long> outside_capture_{0};
+    std::atomic<unsigned long long> over_budget_{0};
+
+    // Zone aggregation. An epoch per set_aggregation(true) discards zones
+    // opened before it was turned on
+    std::atomic<bool> aggregating_{false};
+    std::atomic<unsigned> aggregate_epoch_{0};
+    std::mutex aggregate_mtx_;
+    long long aggregate_since_ns_ = 0;
+    long long aggregated_ns_ = 0;
+    // Totals of exited threads (under registry_mtx_), in ticks
+    struct zone_totals {
+        unsigned threads = 0;
+        unsigned long long count = 0;
+        long long total = 0;
+        long long min = 0;
+        long long max = 0;
+        void merge(unsigned long long n, long long sum, long long lo, long long hi);
+    };
+    zone_totals retired_[zone_count];
+
+    // Rings of every thread that recorded something
+    std::mutex registry_mtx_;
+    std::vector<std::shared_ptr<thread_buffer>> buffers_;
+    unsigned next_thread_id_ = 0;
+
+    // Background writer
+    std::mutex writer_mtx_;
+    std::condition_variable writer_cv_;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+// Scoped zone: records start on construction and stop on destruction.
+// Zones above PROFILE_LEVEL are an empty object, so instrumentation can stay
+// in the code at no cost:
+//   { profile_zone<zone_id::sA_prep> zone; ... }
+template <zone_id Z, bool Enabled = zone_enabled(Z)>
+class profile_zone {
+public:
+    profile_zone() { ProfilePrinter::get().start(Z); }
+    ~profile_zone() { ProfilePrinter::get().stop(Z); }
+    profile_zone(const profile_zone &) = delete;
+    profile_zone &operator=(const profile_zone &) = delete;
+};
+
+template <zone_id Z>
+class profile_zone<Z, false> {
+public:
+    profile_zone() {}
+    profile_zone(const profile_zone &) = delete;
+    profile_zone &operator=(const profile_zone &) = delete;
 };
 
-// Backwards-compatible inline helpers
+// Backwards-compatible inline helpers (named zones, always compiled in)
 inline void write_profile_line(const char *name, long long t, int status) { ProfilePrinter::get().write_line(name, t, status); }
 inline void startProfile(const char *name) { ProfilePrinter::get().start(name); }
 inline void stopProfile(const char *name) { ProfilePrinter::get().stop(name); }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,94 @@
+#ifndef PROFILE_TRACE_H
+#define PROFILE_TRACE_H
+
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+
+// Compact binary profile trace.
+//
+// A file is one or more segments (one per open_file(), so appended runs
+// stay readable). Each segment starts with "PPTR", a version byte and the
+// zigzag varint base time (when the file was opened), followed by tagged
+// records:
+//
+//   0x01 name     varint id, varint length, bytes   (interned stage name)
+//   0x02 thread   varint id                         (following events' thread)
+//   0x04 event    varint name, zigzag dt, zigzag status
+//   0x10+s event  varint name, zigzag dt            (status s in 0..3)
+//
+// dt is the difference to the previous event of the segment (the first
+// one is relative to the base time), so a typical event takes 4-6 bytes.
+
+constexpr unsigned char profile_trace_magic[4] = { 'P', 'P', 'T', 'R' };
+constexpr unsigned char profile_trace_version = 1;
+
+// Appends encoded records to an in-memory buffer
+class trace_encoder {
+public:
+    // Start a new segment: writes the header and forgets interned names
+    void begin_segment(long long base_t);
+
+    void event(unsigned thread, const char *name, long long t, int status);
+
+    // Encoded bytes not yet written out
+    const std::string &data() const { return buf_; }
+    void clear() { buf_.clear(); }
+
+private:
+    unsigned intern(const char *name);
+    void put_varint(unsigned long long v);
+    void put_signed(long long v);
+
+    std::string buf_;
+    std::unordered_map<std::string, unsigned> names_;
+    unsigned thread_ = 0;
+    bool has_thread_ = false;
+    long long prev_t_ = 0;
+};
+
+// One decoded event
+struct trace_record {
+    unsigned segment = 0;      // 1-based, increments at every header
+    long long base_t = 0;      // base time of the segment
+    unsigned thread = 0;
+    const std::string *name = nullptr;   // valid until the next segment starts
+    long long t = 0;
+    int status = 0;            // 0/1 or profile_zone_begin/profile_zone_end
+};
+
+// Reads a trace produced by trace_encoder
+class trace_decoder {
+public:
+    explicit trace_decoder(std::istream &in) : in_(in) {}
+
+    // Next event; false at end of input or on a malformed trace (see failed())
+    bool next(trace_record &rec);
+
+    bool failed() const { return failed_; }
+
+private:
+    bool read_header();
+    bool get_varint(unsigned long long &v);
+    bool get_signed(long long &v);
+    bool fail();
+
+    std::istream &in_;
+    std::deque<std::string> names_;
+    unsigned segment_ = 0;
+    long long base_t_ = 0;
+    unsigned thread_ = 0;
+    long long prev_t_ = 0;
+    bool failed_ = false;
+};
+
+// Same text as the CSV writer of ProfilePrinter (thread,time,status)
+bool trace_to_csv(std::istream &in, std::ostream &out);
+
+// Chrome trace_event JSON (chrome://tracing, Perfetto); zones become B/E
+// pairs, write_line() events become counters. ts is relative to the base
+// time of the first segment.
+bool trace_to_chrome(std::istream &in, std::ostream &out);
+
+#endif // PROFILE_TRACE_H
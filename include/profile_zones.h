@@ -0,0 +1,91 @@
+#ifndef PROFILE_ZONES_H
+#define PROFILE_ZONES_H
+
+// Profiling zones compiled in, set by the PROFILE_LEVEL CMake option.
+// A zone above this level compiles to nothing (see profile_zone in profile_print.h)
+#ifndef PROFILE_LEVEL
+#define PROFILE_LEVEL 2
+#endif
+
+constexpr int profile_level_off = 0;
+constexpr int profile_level_stage = 1;    // one zone per stage cycle: sA, sB, pcA, pcB
+constexpr int profile_level_detail = 2;   // plus the read/prep/wait zones around a cycle
+
+constexpr int profile_level = PROFILE_LEVEL;
+
+// Registered zones. The ID is what recording threads store; the name is
+// only looked up by the writer. Add a zone here, in zone_name and in zone_level
+enum class zone_id : unsigned char {
+    sA,
+    sA_prep,
+    sA_read,
+    sB,
+    sB_prep,
+    sB_read,
+    pcA,
+    pcB,
+    sB_wait,
+    pcA_wait,
+    pcB_wait,
+    count
+};
+
+constexpr unsigned zone_count = (unsigned)zone_id::count;
+
+// Name written to the profile (the "thread" column of the CSV)
+constexpr const char *zone_name(zone_id z)
+{
+    switch (z) {
+    case zone_id::sA: return "sA";
+    case zone_id::sA_prep: return "sA_prep";
+    case zone_id::sA_read: return "sA_read";
+    case zone_id::sB: return "sB";
+    case zone_id::sB_prep: return "sB_prep";
+    case zone_id::sB_read: return "sB_read";
+    case zone_id::pcA: return "pcA";
+    case zone_id::pcB: return "pcB";
+    case zone_id::sB_wait: return "sB_wait";
+    case zone_id::pcA_wait: return "pcA_wait";
+    case zone_id::pcB_wait: return "pcB_wait";
+    case zone_id::count: break;
+    }
+    return "?";
+}
+
+constexpr int zone_level(zone_id z)
+{
+    switch (z) {
+    case zone_id::sA:
+    case zone_id::sB:
+    case zone_id::pcA:
+    case zone_id::pcB: return profile_level_stage;
+    default: return profile_level_detail;
+    }
+}
+
+// Zones spent waiting for input (the rest is work), for utilization reports.
+// *_read: a reader blocked on a source; *_wait: a stage blocked on its queue
+constexpr bool zone_waits(zone_id z)
+{
+    return z == zone_id::sA_read || z == zone_id::sB_read || z == zone_id::sB_wait || z == zone_id::pcA_wait ||
+           z == zone_id::pcB_wait;
+}
+
+// Input wait of a stage-level zone, or zone_id::count if the stage never
+// waits (source_A paces itself)
+constexpr zone_id zone_wait_of(zone_id stage)
+{
+    switch (stage) {
+    case zone_id::sB: return zone_id::sB_wait;
+    case zone_id::pcA: return zone_id::pcA_wait;
+    case zone_id::pcB: return zone_id::pcB_wait;
+    default: return zone_id::count;
+    }
+}
+
+constexpr bool zone_enabled(zone_id z)
+{
+    return zone_level(z) <= profile_level;
+}
+
+#endif // PROFILE_ZONES_H
@@ -0,0 +1,60 @@
+#ifndef RUN_WINDOW_H
+#define RUN_WINDOW_H
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "bench_config.h"
+
+// Throughput of one interval inside the measurement window
+struct interval_sample {
+    int index;            // 1-based
+    double end_s;         // end of the interval, seconds since the window opened
+    long long processed;  // items counted during the interval
+    double elapsed_s;     // measured length of the interval
+    double items_per_s;
+};
+
+// Counter delta over the measurement window, timed with steady_clock
+struct window_result {
+    long long processed = 0;
+    double elapsed_s = 0.0;
+    double items_per_s = 0.0;
+    std::vector<interval_sample> intervals;
+};
+
+/**
+ * @brief Timing of a measured run: warm-in, then a window split in intervals
+ *
+ * The counter is snapshotted when the window opens (after warm-in), at every
+ * interval boundary and when it closes, so thread start-up before the window
+ * and stop()/join after it are not part of the figure. Boundaries are
+ * absolute steady_clock deadlines: oversleeping one does not shift the rest,
+ * and throughput is divided by the measured, not the nominal, time.
+ */
+struct run_window {
+    std::chrono::nanoseconds warm_in{0};
+    std::chrono::nanoseconds measure{std::chrono::seconds(1)};
+    std::chrono::nanoseconds interval{0};   // 0 = a single interval (no samples)
+
+    // From BenchConfig: duration_ms (or duration_s), warm_in_ms, interval_ms
+    static run_window from_config(const BenchConfig *cfg);
+
+    /**
+     * @brief Waits out warm-in and the window, sampling counter at each boundary
+     *
+     * Call right after the pipeline started; stop it after this returns.
+     *
+     * @param counter running total (e.g. get_processed_items)
+     * @param at_open called when the window opens, right after the first
+     *        snapshot (e.g. to reset latency histograms); may be empty
+     * @param on_interval called as each interval closes; may be empty
+     */
+    window_result run(const std::function<long long()> &counter,
+                      const std::function<void()> &at_open = std::function<void()>(),
+                      const std::function<void(const interval_sample &)> &on_interval =
+                          std::function<void(const interval_sample &)>()) const;
+};
+
+#endif // RUN_WINDOW_H
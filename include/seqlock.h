@@ -0,0 +1,98 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * @brief Valor protegido por seqlock: um escritor, leitores sem lock
+ *
+ * O escritor nunca espera: incrementa a sequência (ímpar = escrita em
+ * andamento), copia o valor e publica com um único store release da
+ * sequência par. O leitor copia o valor e repete se a sequência mudou
+ * no meio da cópia (leitura rasgada).
+ *
+ * O valor é guardado em palavras atômicas (acessos relaxed), o que
+ * mantém a leitura concorrente bem definida (e limpa no TSAN).
+ */
+template <typename T>
+class seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock<T> requires a trivially copyable T");
+
+    static constexpr std::size_t words = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    /// Par = estável; ímpar = escrita em andamento
+    std::atomic<unsigned> seq_{0};
+    std::atomic<std::uint64_t> data_[words];
+
+    public:
+        explicit seqlock( const T &initial = T() )
+        {
+            std::uint64_t buf[words] = {};
+            std::memcpy(buf, &initial, sizeof(T));
+            for( std::size_t i = 0; i < words; i++ )
+                data_[i].store(buf[i], std::memory_order_relaxed);
+        }
+
+        seqlock( const seqlock & ) = delete;
+        seqlock &operator=( const seqlock & ) = delete;
+
+        /**
+         * @brief Publica um novo valor (somente uma thread escritora)
+         */
+        void store( const T &value )
+        {
+            std::uint64_t buf[words] = {};
+            std::memcpy(buf, &value, sizeof(T));
+
+            unsigned s = seq_.load(std::memory_order_relaxed);
+            seq_.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for( std::size_t i = 0; i < words; i++ )
+                data_[i].store(buf[i], std::memory_order_relaxed);
+            seq_.store(s + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Uma tentativa de leitura
+         *
+         * @return false se cruzou com uma escrita (out não é alterado)
+         */
+        bool try_load( T &out ) const
+        {
+            unsigned s0 = seq_.load(std::memory_order_acquire);
+            if( s0 & 1 ) return false;
+
+            std::uint64_t buf[words];
+            for( std::size_t i = 0; i < words; i++ )
+                buf[i] = data_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if( seq_.load(std::memory_order_relaxed) != s0 ) return false;
+
+            std::memcpy(&out, buf, sizeof(T));
+            return true;
+        }
+
+        /**
+         * @brief Lê o valor mais recente, repetindo leituras rasgadas
+         */
+        T load( void ) const
+        {
+            T v;
+            for( unsigned spins = 0; !try_load(v); spins++ )
+            {
+                /// Escritor preemptado no meio da cópia: cede a CPU
+                if( spins >= 64 ) std::this_thread::yield();
+            }
+            return v;
+        }
+
+        /// Número de store() já concluídos
+        unsigned version( void ) const { return seq_.load(std::memory_order_acquire) / 2; }
+};
+
+#endif // SEQLOCK_H
@@ -1,7 +1,16 @@
 
 #include "thread_utils.h"
 #include "source_threads.h"
-#include <condition_variable>
+#include "bench_config.h"
+#include "channel.h"
+#include "spsc_ring.h"
+#include "mpmc_queue.h"
+#include "backpressure.h"
+#include "latency_histogram.h"
+#include "workload.h"
+#include "latest_value.h"
+#include <memory>
+#include <vector>
 
 #ifndef SOURCE_PROCESS_THREADS_H
 #define SOURCE_PROCESS_THREADS_H
@@ -18,36 +27,111 @@ struct buffer_source_B
     /// Buffer de dados
     /// Não pode ser manipulado sem ter efetuado a aquisição do semáforo
     int data;
+
+    /// Número de sequência da publicação (1, 2, 3...); 0 = nada publicado
+    unsigned long long seq;
+    /// Instante da publicação do item de origem em source_A, para a latência fim a fim
+    long long origin_ns;
+};
+
+/**
+ * @brief Quadro produzido por source_B
+ * 
+ * Vem do payload_pool da source e trafega pelas filas como item_B.
+ * 
+ */
+struct frame_B
+{
+    /// Cabeçalho (o mesmo valor exposto por read())
+    buffer_source_B head;
+    unsigned char body[frame_body_bytes];
 };
 
+/// Item das filas de source_B
+typedef payload_handle<frame_B> item_B;
+
 
 /**
  * @brief Classe de processo e source
  * 
  * Está classe efetua o processamento de uma outra source,
  * gerando uma nova informação que poderá ser utilizada por outras
- * threads. Devendo ser thread-safe. Usa condition_variable para
- * notificar leitores sobre novos dados processados.
+ * threads. Devendo ser thread-safe. Cada consumidor inscrito via
+ * subscribe() recebe uma fila SPSC própria; várias instâncias podem
+ * compartilhar filas MPMC de entrada/saída (fan-out/fan-in). O último
+ * valor continua disponível em read(), via um canal latest_value
+ * (leituras sem lock) para observadores.
  * 
  */
 class source_B : public thread_base
 {
-    source_A *cap;
+    /// Fila de entrada (inscrita em source_A ou compartilhada)
+    channel<item_A> *in;
+
+    /// Optional pointer to config (capacidade das filas)
+    BenchConfig *cfg;
+
+    /// Latências (opcional, definido pelo Pipeline)
+    pipeline_metrics *metrics = nullptr;
+
+    /// Trabalho simulado do estágio (BenchConfig::workload)
+    workload work;
+
+    /// Último valor publicado; lido sem lock por read()/read_since()
+    latest_value<buffer_source_B> latest_;
+    /// Último seq gerado, acessado somente pela thread produtora
+    unsigned long long seq_;
+
+    /// Lote lido da entrada e lote gerado (BenchConfig::batch_size)
+    std::vector<item_A> in_batch;
+    std::vector<item_B> out_batch;
+
+    /// Pool próprio, usado enquanto set_frames() não indicar outro; declarado
+    /// antes das filas para ser destruído depois delas
+    std::unique_ptr<payload_pool<frame_B>> own_frames_;
+    /// Pool dos quadros entregues às filas
+    payload_pool<frame_B> *frames_;
+
+    /// Filas de saída; cada item publicado é entregue em todas
+    std::vector<channel<item_B> *> outputs_;
+    /// Política de fila cheia de cada saída (paralelo a outputs_)
+    std::vector<overflow_policy> policies_;
 
-    buffer_source_B buffer;
-    std::condition_variable cv_;
+    /// Filas criadas por subscribe(), pertencem a esta source
+    std::vector<std::unique_ptr<channel<item_B>>> owned_;
 
     /**
      * @brief Inicializa o classe
      * 
-     * @param cap_ ponteiro para classe de captura
+     * @param in_ fila de entrada
+     * @param cfg_ configuração opcional
      */
-    void init( source_A *cap_ )
+    void init( channel<item_A> *in_, BenchConfig *cfg_ = nullptr )
     {
-        cap = cap_;
-        buffer.data = 0;
+        in = in_;
+        cfg = cfg_;
+        work = workload::for_stage(cfg_, "sB");
+        work.set_stop_token(get_stop_token());
+        latest_.set_wait_strategy(wait_strategy_for(cfg_, "sB"));
+        seq_ = 0;
+        in_batch.resize(batch_size_of(cfg_));
+        out_batch.resize(in_batch.size());
+        own_frames_.reset(new payload_pool<frame_B>(payload_capacity_of(cfg_)));
+        frames_ = own_frames_.get();
     }
 
+    /**
+     * @brief Entrega um lote de itens para todas as filas de saída
+     * 
+     * Com a fila cheia segue a política da saída (block: espera
+     * enquanto a thread estiver ativa).
+     * Cada fila é notificada uma vez por lote.
+     * 
+     * @param items itens contíguos
+     * @param count quantidade de itens
+     */
+    void publish_batch( const item_B *items, std::size_t count );
+
     public:
 
         /**
@@ -66,7 +150,23 @@ class source_B : public thread_base
          */
         source_B( source_A *cap_ ) : thread_base()
         { 
-            this->init(cap_);
+            this->init(cap_ ? cap_->subscribe() : NULL);
+        };
+
+        source_B( source_A *cap_, BenchConfig *cfg_ ) : thread_base()
+        {
+            this->init(cap_ ? cap_->subscribe() : NULL, cfg_);
+        };
+
+        /**
+         * @brief Contrutor para source_B 
+         * 
+         * @param in_ fila de entrada, possivelmente compartilhada com outras instâncias
+         * @param cfg_ configuração opcional
+         */
+        source_B( channel<item_A> *in_, BenchConfig *cfg_ ) : thread_base()
+        {
+            this->init(in_, cfg_);
         };
 
         /**
@@ -80,22 +180,104 @@ class source_B : public thread_base
         void run( void ) override;
 
         /**
-         * @brief Efetua o processamento do dado lido, gerando um novo dado
+         * @brief Gera um quadro de saída a partir de um quadro de entrada
+         * 
+         * Não publica: run() entrega o lote gerado de uma só vez.
          * 
-         * @param buffer ponteiro para o dado
+         * @param in quadro lido de source_A (compartilhado, somente leitura)
+         * @param out quadro obtido do pool desta source
          */
-        void process_buffer( int *value );
+        void process_buffer( const frame_A &in, frame_B &out );
 
         /**
          * @brief Efetua leitura do buffer, do valor que foi gerado
          * utilizando a outra source
          * 
-         * Realiza a leitura do buffer de modo thread-safe
+         * Realiza a leitura do buffer de modo thread-safe. Espera até que
+         * algum valor tenha sido publicado (ou a source não esteja ativa)
+         * e retorna o mais recente, que pode já ter sido lido antes.
          * 
          * @param dado ponteiro pegar o valor que está no buffer
          */
         void read( buffer_source_B *dado );
+
+        /**
+         * @brief Lê o valor mais recente, se for mais novo que last_seq
+         * 
+         * Bloqueia até uma publicação com seq > last_seq, por no máximo
+         * stage_wait_timeout. Cada publicação acorda os leitores uma única vez.
+         * 
+         * @param last_seq último seq já processado pelo leitor (0 = nenhum)
+         * @param dado ponteiro para receber o valor (dado->seq é o novo seq)
+         * @return quantidade de publicações puladas desde last_seq,
+         *         ou -1 se nenhum valor novo chegou a tempo
+         */
+        long long read_since( unsigned long long last_seq, buffer_source_B *dado );
+
+        /**
+         * @brief Cria uma fila de entrega para um novo consumidor
+         * 
+         * Deve ser chamada antes de start(). A capacidade vem de
+         * BenchConfig::queue_capacity e a política de fila cheia de
+         * BenchConfig::backpressure.
+         * 
+         * @return fila SPSC (MPMC com drop_oldest), lida pelo consumidor com pop_wait()
+         */
+        channel<item_B> *subscribe( void );
+
+        /**
+         * @brief Anexa uma fila de saída externa
+         * 
+         * Usado para filas compartilhadas (MPMC) entre vários estágios.
+         * Deve ser chamada antes de start(); a fila deve viver mais que a source.
+         * 
+         * @param out fila que passa a receber cada item publicado
+         * @param policy o que fazer quando out estiver cheia; drop_oldest
+         *               requer fila com out->evictable()
+         */
+        void attach( channel<item_B> *out, overflow_policy policy = overflow_policy::block );
+
+        /**
+         * @brief Define onde registrar as latências do estágio
+         * 
+         * Deve ser chamada antes de start(); nullptr desativa o registro.
+         * 
+         * @param m métricas do pipeline, devem viver mais que o estágio
+         */
+        void set_metrics( pipeline_metrics *m ) { metrics = m; }
+
+        /**
+         * @brief Usa um pool externo para os quadros (ex.: o do Pipeline)
+         * 
+         * Deve ser chamada antes de start(); o pool próprio é liberado.
+         * 
+         * @param pool pool compartilhado, deve viver mais que as filas e consumidores
+         */
+        void set_frames( payload_pool<frame_B> *pool )
+        {
+            frames_ = pool;
+            own_frames_.reset();
+        }
+
+        /// Pool dos quadros publicados (estatísticas)
+        const payload_pool<frame_B> &frames( void ) const { return *frames_; }
+
+        /**
+         * @brief Como leitores de read()/read_since() esperam um valor novo
+         *
+         * Por padrão a de BenchConfig para o estágio "sB".
+         */
+        void set_wait_strategy( wait_strategy s ) { latest_.set_wait_strategy(s); }
+
+        /**
+         * @brief Volta ao estado inicial, com o estágio pausado ou parado
+         *
+         * Reinicia a sequência, publica um valor vazio (seq 0) para read()
+         * e esvazia as filas criadas por subscribe(). As filas anexadas com
+         * attach() pertencem a quem as criou (ex.: Pipeline::reset()).
+         */
+        void reset_state( void ) override;
         // implementations moved to src/source_process_threads.cpp
 };
 
-#endif
\ No newline at end of file
+#endif
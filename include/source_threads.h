@@ -1,58 +1,221 @@
-
 #ifndef SOURCE_THREADS_H
 #define SOURCE_THREADS_H
 
 #include "thread_utils.h"
 #include "profile_print.h"
-#include <condition_variable>
+#include "bench_config.h"
+#include "channel.h"
+#include "spsc_ring.h"
+#include "mpmc_queue.h"
+#include "backpressure.h"
+#include "latency_histogram.h"
+#include "workload.h"
+#include "latest_value.h"
+#include "payload.h"
+#include <memory>
+#include <vector>
 
 /**
  * @brief Estrutura para armazenar buffers da clase de coelta A
- * 
+ *
  */
 struct buffer_source_A
 {
     /// Buffer de dados
     /// Não pode ser manipulado sem ter efetuado a aquisição do semáforo
     int data;
+
+    /// Número de sequência da publicação (1, 2, 3...); 0 = nada publicado
+    unsigned long long seq;
+    /// Instante da publicação em source_A (latency_now_ns()), para a latência fim a fim
+    long long origin_ns;
+};
+
+/// Bytes de dados de um quadro (os payloads reais têm alguns KB)
+constexpr std::size_t frame_body_bytes = 4096;
+
+/**
+ * @brief Quadro produzido por source_A
+ *
+ * Vem do payload_pool da source e trafega pelas filas como item_A:
+ * somente o ponteiro cruza cada fila.
+ */
+struct frame_A
+{
+    /// Cabeçalho (o mesmo valor exposto por read())
+    buffer_source_A head;
+    unsigned char body[frame_body_bytes];
 };
 
+/// Item das filas de source_A
+typedef payload_handle<frame_A> item_A;
+
 
 /**
  * \brief Classe que define uma fonte de dados
- * 
+ *
  * Esta classe tem como objetivo capturar dados de alguma fonte,
- * para deixa-los disponiveis em um buffer circular de tamanho 1.
- * Usa condition_variable para notificar leitores sobre novos dados.
- *  
+ * para deixa-los disponiveis aos consumidores. Cada captura gera um
+ * frame_A, tirado de um pool pré-alocado. Cada consumidor inscrito
+ * via subscribe() recebe uma fila SPSC própria; grupos de consumidores
+ * podem compartilhar uma fila MPMC anexada via attach(). Com a política
+ * padrão (block) nenhum item é perdido; cada saída pode descartar sob
+ * sobrecarga (overflow_policy). A entrega não utiliza mutex.
+ * O último valor também fica disponível em read(), para observadores,
+ * via um canal latest_value: leituras sem lock e sem custo para a
+ * source por leitor adicional.
+ *
 */
 class source_A : public thread_base
 {
-    buffer_source_A buffer;
-    std::condition_variable cv_;
+    /// Último valor publicado; lido sem lock por read()/read_since()
+    latest_value<buffer_source_A> latest_;
+    /// Estado do produtor, acessado somente pela thread de run()
+    buffer_source_A next_;
+
+    /// Optional pointer to config (capacidade das filas)
+    BenchConfig *cfg;
+
+    /// Latências (opcional, definido pelo Pipeline)
+    pipeline_metrics *metrics = nullptr;
+
+    /// Trabalho simulado do estágio (BenchConfig::workload)
+    workload work;
+
+    /// Pool próprio, usado enquanto set_frames() não indicar outro; declarado
+    /// antes das filas para ser destruído depois delas
+    std::unique_ptr<payload_pool<frame_A>> own_frames_;
+    /// Pool dos quadros entregues às filas
+    payload_pool<frame_A> *frames_;
+
+    /// Filas de saída; cada item publicado é entregue em todas
+    std::vector<channel<item_A> *> outputs_;
+    /// Política de fila cheia de cada saída (paralelo a outputs_)
+    std::vector<overflow_policy> policies_;
+
+    /// Filas criadas por subscribe(), pertencem a esta source
+    std::vector<std::unique_ptr<channel<item_A>>> owned_;
+
+    /**
+     * @brief Entrega um lote de itens para todas as filas de saída
+     *
+     * Com a fila cheia segue a política da saída (block: espera
+     * enquanto a thread estiver ativa).
+     * Cada fila é notificada uma vez por lote.
+     *
+     * @param items itens contíguos
+     * @param count quantidade de itens
+     */
+    void publish_batch( const item_A *items, std::size_t count );
 
     public:
-        source_A( void ) : thread_base()
+        source_A( BenchConfig *cfg_ = nullptr ) : thread_base(), cfg(cfg_), work(workload::for_stage(cfg_, "sA")),
+                                                  own_frames_(new payload_pool<frame_A>(payload_capacity_of(cfg_))),
+                                                  frames_(own_frames_.get())
         {
             /// Inicializa os valores do buffer
-            buffer.data = 0;
+            next_.data = 0;
+            next_.seq = 0;
+            next_.origin_ns = 0;
+            latest_.set_wait_strategy(wait_strategy_for(cfg_, "sA"));
+            work.set_stop_token(get_stop_token());
         }
 
         /**
          * @brief Funcão principal da classe source
-         * 
+         *
          * Função de captura e atualização do buffer de captura
          */
         void run( void ) override;
 
         /**
          * @brief Efetua leitura do buffer
-         * 
-         * Realiza a leitura do buffer de modo thread-safe
-         * 
+         *
+         * Realiza a leitura do buffer de modo thread-safe, sem lock quando
+         * já existe um valor. Espera até que algum valor tenha sido publicado
+         * (ou a source não esteja ativa) e retorna o mais recente, que pode
+         * já ter sido lido antes.
+         *
          * @param dado ponteiro pegar o valor que está no buffer
          */
         void read( buffer_source_A *dado );
+
+        /**
+         * @brief Lê o valor mais recente, se for mais novo que last_seq
+         *
+         * Bloqueia até uma publicação com seq > last_seq, por no máximo
+         * stage_wait_timeout. Cada publicação acorda os leitores uma única vez.
+         *
+         * @param last_seq último seq já processado pelo leitor (0 = nenhum)
+         * @param dado ponteiro para receber o valor (dado->seq é o novo seq)
+         * @return quantidade de publicações puladas desde last_seq,
+         *         ou -1 se nenhum valor novo chegou a tempo
+         */
+        long long read_since( unsigned long long last_seq, buffer_source_A *dado );
+
+        /**
+         * @brief Cria uma fila de entrega para um novo consumidor
+         *
+         * Deve ser chamada antes de start(). A capacidade vem de
+         * BenchConfig::queue_capacity e a política de fila cheia de
+         * BenchConfig::backpressure.
+         *
+         * @return fila SPSC (MPMC com drop_oldest), lida pelo consumidor com pop_wait()
+         */
+        channel<item_A> *subscribe( void );
+
+        /**
+         * @brief Anexa uma fila de saída externa
+         *
+         * Usado para filas compartilhadas (MPMC) entre vários estágios.
+         * Deve ser chamada antes de start(); a fila deve viver mais que a source.
+         *
+         * @param out fila que passa a receber cada item publicado
+         * @param policy o que fazer quando out estiver cheia; drop_oldest
+         *               requer fila com out->evictable()
+         */
+        void attach( channel<item_A> *out, overflow_policy policy = overflow_policy::block );
+
+        /**
+         * @brief Define onde registrar as latências do estágio
+         *
+         * Deve ser chamada antes de start(); nullptr desativa o registro.
+         *
+         * @param m métricas do pipeline, devem viver mais que o estágio
+         */
+        void set_metrics( pipeline_metrics *m ) { metrics = m; }
+
+        /**
+         * @brief Usa um pool externo para os quadros (ex.: o do Pipeline)
+         *
+         * Deve ser chamada antes de start(); o pool próprio é liberado.
+         *
+         * @param pool pool compartilhado, deve viver mais que as filas e consumidores
+         */
+        void set_frames( payload_pool<frame_A> *pool )
+        {
+            frames_ = pool;
+            own_frames_.reset();
+        }
+
+        /// Pool dos quadros publicados (estatísticas)
+        const payload_pool<frame_A> &frames( void ) const { return *frames_; }
+
+        /**
+         * @brief Como leitores de read()/read_since() esperam um valor novo
+         *
+         * Por padrão a de BenchConfig para o estágio "sA".
+         */
+        void set_wait_strategy( wait_strategy s ) { latest_.set_wait_strategy(s); }
+
+        /**
+         * @brief Volta ao estado inicial, com o estágio pausado ou parado
+         *
+         * Reinicia a sequência, publica um valor vazio (seq 0) para read()
+         * e esvazia as filas criadas por subscribe(). As filas anexadas com
+         * attach() pertencem a quem as criou (ex.: Pipeline::reset()).
+         */
+        void reset_state( void ) override;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,158 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "cache_line.h"
+#include "channel.h"
+
+/**
+ * @brief Buffer circular lock-free, um produtor e um consumidor
+ *
+ * Os índices de escrita (head) e leitura (tail) ficam em linhas de cache
+ * separadas. Cada lado mantém uma cópia local do índice do outro lado,
+ * só relendo o atômico quando a cópia indica buffer cheio/vazio.
+ *
+ * A capacidade é arredondada para a próxima potência de 2.
+ *
+ * @tparam T tipo armazenado (copiável; removido da posição por move)
+ */
+template <typename T>
+class spsc_ring : public channel<T>
+{
+    public:
+        /**
+         * @brief Cria o buffer
+         *
+         * @param capacity número mínimo de elementos (0 usa default_queue_capacity)
+         */
+        explicit spsc_ring( std::size_t capacity = default_queue_capacity )
+        {
+            std::size_t cap = 1;
+            if( capacity == 0 ) capacity = default_queue_capacity;
+            while( cap < capacity ) cap <<= 1;
+
+            slots_.resize(cap);
+            mask_ = cap - 1;
+        }
+
+        spsc_ring( const spsc_ring & ) = delete;
+        spsc_ring &operator=( const spsc_ring & ) = delete;
+
+        /**
+         * @brief Insere um elemento (somente a thread produtora)
+         *
+         * @return false se o buffer está cheio
+         */
+        bool try_push( const T &value ) override
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if( head - tail_cache_ > mask_ )
+            {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if( head - tail_cache_ > mask_ )
+                    return false;
+            }
+
+            slots_[head & mask_] = value;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Remove um elemento (somente a thread consumidora)
+         *
+         * @return false se o buffer está vazio
+         */
+        bool try_pop( T &value ) override
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if( tail == head_cache_ )
+            {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if( tail == head_cache_ )
+                    return false;
+            }
+
+            value = std::move(slots_[tail & mask_]);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Insere até n elementos com uma única publicação do índice
+         *
+         * @return quantidade inserida
+         */
+        std::size_t try_push_batch( const T *items, std::size_t n ) override
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            std::size_t free_slots = capacity() - (head - tail_cache_);
+            if( free_slots < n )
+            {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                free_slots = capacity() - (head - tail_cache_);
+            }
+
+            const std::size_t k = n < free_slots ? n : free_slots;
+            for( std::size_t i = 0; i < k; i++ )
+                slots_[(head + i) & mask_] = items[i];
+            if( k > 0 )
+                head_.store(head + k, std::memory_order_release);
+            return k;
+        }
+
+        /**
+         * @brief Remove até max elementos com uma única atualização do índice
+         *
+         * @return quantidade removida
+         */
+        std::size_t try_pop_batch( T *out, std::size_t max ) override
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            std::size_t available = head_cache_ - tail;
+            if( available < max )
+            {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                available = head_cache_ - tail;
+            }
+
+            const std::size_t k = max < available ? max : available;
+            for( std::size_t i = 0; i < k; i++ )
+                out[i] = std::move(slots_[(tail + i) & mask_]);
+            if( k > 0 )
+                tail_.store(tail + k, std::memory_order_release);
+            return k;
+        }
+
+        /// Número aproximado de elementos armazenados
+        std::size_t size( void ) const override
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        std::size_t capacity( void ) const override { return mask_ + 1; }
+
+        /// Só o consumidor remove: drop_oldest não se aplica
+        bool evictable( void ) const override { return false; }
+
+    private:
+        std::vector<T> slots_;
+        std::size_t mask_;
+        char pad_ro_[cache_line_size];
+
+        /// Lado produtor: índice de escrita e cópia local do índice de leitura
+        std::atomic<std::size_t> head_{0};
+        std::size_t tail_cache_{0};
+        char pad_head_[cache_line_size];
+
+        /// Lado consumidor: índice de leitura e cópia local do índice de escrita
+        std::atomic<std::size_t> tail_{0};
+        std::size_t head_cache_{0};
+        char pad_tail_[cache_line_size];
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,82 @@
+#ifndef STOP_TOKEN_H
+#define STOP_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Cooperative cancellation (a C++14 take on std::stop_source/std::stop_token).
+// The owner requests a stop; code holding a token polls stop_requested() in
+// loops and calls sleep_for() instead of std::this_thread::sleep_for, so a
+// stop cuts the sleep short instead of waiting it out.
+
+class stop_token;
+
+// Owner side. Not copyable: tokens point at it, so it must outlive them
+class stop_source
+{
+    public:
+        stop_source() = default;
+        stop_source( const stop_source & ) = delete;
+        stop_source &operator=( const stop_source & ) = delete;
+
+        // Sets the flag and wakes every sleep_for() in progress
+        void request_stop()
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            requested_.store(true, std::memory_order_release);
+            cv_.notify_all();
+        }
+
+        // Clears the flag (e.g. before the owner runs again); tokens stay valid
+        void reset() { requested_.store(false, std::memory_order_release); }
+
+        bool stop_requested() const { return requested_.load(std::memory_order_acquire); }
+
+        stop_token token() const;
+
+        // Sleeps for d or until request_stop(). Returns false if interrupted
+        bool sleep_for( std::chrono::nanoseconds d ) const
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            return !cv_.wait_for(lk, d, [this] { return stop_requested(); });
+        }
+
+    private:
+        std::atomic<bool> requested_{false};
+        mutable std::mutex mtx_;
+        mutable std::condition_variable cv_;
+};
+
+// Reader side, cheap to copy. A default-constructed token is never stopped
+class stop_token
+{
+    public:
+        stop_token() = default;
+
+        bool stop_requested() const { return src_ && src_->stop_requested(); }
+
+        // True if a stop can ever be requested through this token
+        bool stop_possible() const { return src_ != nullptr; }
+
+        // Sleeps for d or until a stop is requested. Returns false if interrupted
+        bool sleep_for( std::chrono::nanoseconds d ) const
+        {
+            if( d.count() <= 0 ) return !stop_requested();
+            if( src_ ) return src_->sleep_for(d);
+            std::this_thread::sleep_for(d);
+            return true;
+        }
+
+    private:
+        friend class stop_source;
+        explicit stop_token( const stop_source *src ) : src_(src) {}
+
+        const stop_source *src_ = nullptr;
+};
+
+inline stop_token stop_source::token() const { return stop_token(this); }
+
+#endif // STOP_TOKEN_H
@@ -0,0 +1,120 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "event_count.h"
+
+/**
+ * @brief Executor com roubo de tarefas (work-stealing)
+ *
+ * Cada worker tem uma deque própria: tarefas submetidas de dentro de um
+ * worker vão para a sua deque (consumida pelo fim, LIFO) e tarefas de fora
+ * do pool vão para a fila global de injeção. A cada tarefa um worker tenta,
+ * nesta ordem: a fila global (quando não vazia), a própria deque e o início
+ * da deque dos outros workers. Sem nada para fazer, estaciona em um
+ * event_count. A fila global vem primeiro porque tarefas recorrentes
+ * reagendadas na deque local nunca a esvaziam: um estágio iniciado de fora
+ * (start(), resume()) não espera atrás delas.
+ *
+ * Permite executar muitos estágios (thread_base) em um número fixo de threads.
+ */
+class thread_pool
+{
+    public:
+        typedef std::function<void()> task;
+
+        /**
+         * @brief Cria o pool e inicia os workers
+         *
+         * @param workers número de threads (0 = std::thread::hardware_concurrency)
+         */
+        explicit thread_pool( std::size_t workers = 0 );
+
+        /**
+         * @brief Para e aguarda os workers
+         *
+         * Tarefas ainda não executadas são descartadas.
+         */
+        ~thread_pool();
+
+        thread_pool( const thread_pool & ) = delete;
+        thread_pool &operator=( const thread_pool & ) = delete;
+
+        /**
+         * @brief Agenda uma tarefa
+         *
+         * De um worker deste pool: fim da deque local (executa em seguida).
+         * De outra thread: fila global de injeção.
+         */
+        void submit( task t );
+
+        /**
+         * @brief Reagenda uma tarefa recorrente, sem furar a fila
+         *
+         * De um worker deste pool: início da deque local, executada depois
+         * das demais tarefas locais e a primeira a ser roubada.
+         * De outra thread: equivale a submit().
+         */
+        void reschedule( task t );
+
+        /**
+         * @brief Executa uma tarefa pendente na thread atual
+         *
+         * Para uma tarefa que precisa esperar (ex.: fila cheia) sem segurar
+         * o worker: o consumidor que ela espera pode estar na fila do pool.
+         * Como cada estágio tem no máximo uma tarefa, o aninhamento é
+         * limitado ao número de estágios.
+         *
+         * @return false fora de um worker deste pool ou sem tarefas
+         */
+        bool run_pending( void );
+
+        /// Número de workers
+        std::size_t size( void ) const { return threads_.size(); }
+
+        /// Quantas tarefas foram roubadas de outros workers
+        unsigned long long steal_count( void ) const { return steals_.load(std::memory_order_relaxed); }
+
+        /// Pool do worker que chama, ou nullptr fora de um worker
+        static thread_pool *current( void );
+
+    private:
+        struct worker
+        {
+            std::mutex mtx;
+            std::deque<task> tasks;
+        };
+
+        void worker_main( std::size_t index );
+        bool take( std::size_t index, task &t );
+        static void execute( task &t );
+        bool pop_local( std::size_t index, task &t );
+        bool pop_global( task &t );
+        bool steal( std::size_t thief, task &t );
+
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        /// Fila global de injeção (submissões de fora do pool)
+        std::mutex global_mtx_;
+        std::deque<task> global_;
+
+        /// Tamanho de global_, para checar sem o lock
+        std::atomic<std::size_t> global_size_{0};
+
+        /// Sinalizado a cada tarefa submetida
+        event_count work_ready_;
+
+        std::atomic<bool> stopping_{false};
+        std::atomic<unsigned long long> steals_{0};
+};
+
+#endif // THREAD_POOL_H
@@ -1,17 +1,36 @@
+#ifndef THREADS_UTILS_H
+#define THREADS_UTILS_H
 
 #include <iostream>
 #include <thread>         // std::thread
 #include <mutex>          // std::mutex
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
 
-#ifndef THREADS_UTILS_H
-#define THREADS_UTILS_H
+#include "cpu_affinity.h"
+#include "payload_cache.h"
+#include "thread_pool.h"
+#include "stop_token.h"
+
+/// Tempo máximo que um estágio fica bloqueado esperando dados (ou espaço)
+/// antes de retornar de run() e reavaliar isActive()
+constexpr std::chrono::milliseconds stage_wait_timeout{20};
+
+/// O mesmo para um estágio no thread_pool: curto, para que um estágio sem
+/// dados devolva o worker aos demais e seja reagendado
+constexpr std::chrono::milliseconds pool_wait_timeout{1};
 
 /**
  * @brief Classe base para funcionamento das thread
  * 
  * Implementas as funções principais para trabalhar com uma thread
- * no formato de pipeline
+ * no formato de pipeline. O laço de run() pode executar em uma
+ * std::thread dedicada (start()) ou como tarefa recorrente em um
+ * thread_pool compartilhado (start(pool)). Entre execuções a thread
+ * pode ser estacionada com pause() e retomada com resume(), sem ser
+ * recriada.
 */
 class thread_base
 {
@@ -22,31 +41,167 @@ class thread_base
         /// Thread worker (stored here so Pipeline can manage it)
         std::thread worker_thread;
         
+        /// Pool onde run() é agendado (nullptr = thread dedicada)
+        thread_pool *pool_ = nullptr;
+
+        /// Existe uma tarefa deste estágio agendada ou executando no pool
+        std::atomic<bool> task_pending{false};
+
+        /// Serializa start()/stop() chamados de threads diferentes
+        std::mutex lifecycle_mtx;
+
+        /// CPUs da thread dedicada (vazio = sem afinidade)
+        std::vector<int> affinity_;
+
+        /// CPUs permitidas à thread dedicada, lidas por ela ao iniciar (protegido por park_mtx)
+        std::vector<int> running_cpus_;
+
+        /// pause() pedido: run() deve retornar e a thread estacionar
+        std::atomic<bool> pause_requested{false};
+
+        /// A thread dedicada está estacionada (protegido por park_mtx)
+        bool parked = false;
+
+        /// Estacionamento entre execuções; também sinaliza o fim da tarefa no pool
+        std::mutex park_mtx;
+        std::condition_variable park_cv;
+
+        /// Acionado por stop() e request_pause(): interrompe esperas e trabalho em run()
+        stop_source stop_;
+
+        /// finish() pedido: o laço termina depois do run() atual
+        std::atomic<bool> finish_requested{false};
+
+        /// Caches de payload_pool usados por run() quando executa no thread_pool
+        payload_detail::thread_caches payload_caches_;
+
+        /**
+         * @brief Encerra o laço se finish() foi pedido
+         */
+        void finish_if_requested()
+        {
+            if( finish_requested.load(std::memory_order_acquire) )
+                active.store(false, std::memory_order_release);
+        }
+
+        /**
+         * @brief Estaciona a thread dedicada até resume() ou stop()
+         */
+        void park()
+        {
+            std::unique_lock<std::mutex> lk(park_mtx);
+            parked = true;
+            park_cv.notify_all();
+            park_cv.wait(lk, [this] {
+                return !pause_requested.load(std::memory_order_acquire) || !active.load(std::memory_order_acquire);
+            });
+            parked = false;
+        }
+
+        /**
+         * @brief Marca a tarefa do pool como encerrada e avisa wait_paused()
+         */
+        void finish_task()
+        {
+            std::lock_guard<std::mutex> lk(park_mtx);
+            task_pending.store(false, std::memory_order_release);
+            park_cv.notify_all();
+        }
+
+        /**
+         * @brief Estágio cujo run() está executando na thread atual
+         */
+        static thread_base *&current( void )
+        {
+            static thread_local thread_base *cur = nullptr;
+            return cur;
+        }
+
+        /**
+         * @brief Executa run() uma vez, tratando exceções
+         */
+        void run_once()
+        {
+            thread_base *prev = current();
+            current() = this;
+            try
+            {
+                this->run();
+            }
+            catch( const std::exception &e )
+            {
+                std::cerr << "[thread_base] Exceção capturada: " << e.what() << std::endl;
+            }
+            catch( ... )
+            {
+                std::cerr << "[thread_base] Exceção desconhecida capturada" << std::endl;
+            }
+            current() = prev;
+        }
+
         /**
          * @brief Loop principal executado em thread separada
          * 
          * Esta é a função que roda na std::thread criada em start().
-         * Executa o laço infinito e trata exceções.
+         * Aplica a afinidade configurada, executa o laço infinito e
+         * trata exceções.
          */
         void thread_main()
         {
+            if( !pin_current_thread(affinity_) )
+                std::cerr << "[thread_base] Não foi possível fixar a thread nas CPUs pedidas" << std::endl;
+            {
+                std::vector<int> cpus = current_thread_cpus();
+                std::lock_guard<std::mutex> lk(park_mtx);
+                running_cpus_ = cpus;
+            }
+
             while( active.load(std::memory_order_acquire) )
             {
-                try
+                if( pause_requested.load(std::memory_order_acquire) )
+                    park();
+                else
                 {
-                    this->run();
-                }
-                catch( const std::exception &e )
-                {
-                    std::cerr << "[thread_base] Exceção capturada: " << e.what() << std::endl;
-                }
-                catch( ... )
-                {
-                    std::cerr << "[thread_base] Exceção desconhecida capturada" << std::endl;
+                    run_once();
+                    finish_if_requested();
                 }
             }
         }
 
+        /**
+         * @brief Uma iteração do laço, como tarefa do pool
+         *
+         * Reagenda a si mesma enquanto o estágio estiver ativo e não
+         * pausado; resume() agenda de novo.
+         */
+        void pool_task()
+        {
+            if( isActive() )
+            {
+                run_once();
+                finish_if_requested();
+            }
+
+            if( isActive() )
+                pool_->reschedule([this] { pool_task(); });
+            else
+                finish_task();
+        }
+
+        /**
+         * @brief Aguarda o fim da execução anterior (thread ou tarefa)
+         *
+         * Necessário quando run() chamou stop() sobre si mesmo, que não
+         * pode aguardar a própria thread. Deve ser chamada com lifecycle_mtx.
+         */
+        void join_previous()
+        {
+            if ( worker_thread.joinable() )
+                worker_thread.join();
+            std::unique_lock<std::mutex> plk(park_mtx);
+            park_cv.wait(plk, [this] { return !task_pending.load(std::memory_order_acquire); });
+        }
+
     public:
         /// Semáforo para utilização de variáveis sensíveis
         std::mutex mtx;
@@ -63,36 +218,265 @@ class thread_base
          */
         virtual void start ( void )
         {
+            start( nullptr );
+        }
+
+        /**
+         * @brief Inicia o laço em um executor
+         *
+         * @param pool pool compartilhado; nullptr cria uma std::thread dedicada.
+         *             O pool deve existir até stop() retornar.
+         */
+        void start ( thread_pool *pool )
+        {
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
             if ( active.load(std::memory_order_acquire) )
                 return;
             
+            join_previous();
+            pause_requested.store(false, std::memory_order_release);
+            finish_requested.store(false, std::memory_order_release);
+            stop_.reset();
+            {
+                std::lock_guard<std::mutex> plk(park_mtx);
+                running_cpus_.clear();
+            }
             active.store(true, std::memory_order_release);
-            worker_thread = std::thread( &thread_base::thread_main, this );
+            pool_ = pool;
+            if ( pool_ )
+            {
+                task_pending.store(true, std::memory_order_release);
+                pool_->submit([this] { pool_task(); });
+            }
+            else
+                worker_thread = std::thread( &thread_base::thread_main, this );
         }
 
         /**
          * @brief Para thread
          * 
          * Função que deve executar a finalização da thread
-         * que não poderá mais ser reativa
+         * que não poderá mais ser reativa. Aciona o stop_token, então
+         * esperas e trabalho simulado em andamento terminam logo; o lote
+         * em mãos pode ficar sem processar. Quando chamada de dentro
+         * de run(), apenas sinaliza; a próxima chamada de start() ou
+         * stop() aguarda a execução terminar.
          * 
          */
         virtual void stop ( void )
+        {
+            request_stop();
+            if ( current() == this )
+                return;
+
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
+            join_previous();
+        }
+
+        /**
+         * @brief Sinaliza a parada sem aguardar a thread
+         *
+         * Permite sinalizar todos os estágios (e acordar as filas) antes
+         * de aguardar cada um com stop().
+         */
+        void request_stop ( void )
         {
             active.store(false, std::memory_order_release);
-            if ( worker_thread.joinable() )
-                worker_thread.join();
+            stop_.request_stop();
+            std::lock_guard<std::mutex> plk(park_mtx);
+            park_cv.notify_all();
+        }
+
+        /**
+         * @brief Pede que o laço termine depois do run() atual, sem interrompê-lo
+         *
+         * Não espera: use finish(). Ao contrário de stop(), o stop_token
+         * não é acionado e isActive() continua true até run() retornar,
+         * então o lote em mãos é processado e publicado por inteiro.
+         */
+        void request_finish ( void )
+        {
+            finish_requested.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Termina depois do run() atual e aguarda a thread
+         *
+         * Usada pelo Pipeline para esvaziar o grafo (stop_mode::drain).
+         * Um estágio pausado é parado com stop().
+         */
+        void finish ( void )
+        {
+            if ( paused() )
+            {
+                stop();
+                return;
+            }
+            request_finish();
+            if ( current() == this )
+                return;
+
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
+            join_previous();
+        }
+
+        /**
+         * @brief Pede que o laço pare após o run() atual, sem encerrar a thread
+         *
+         * Não espera: use wait_paused() (ou pause()). Enquanto pausado,
+         * isActive() é false e o stop_token é acionado, então esperas em
+         * filas, leituras e trabalho simulado terminam como em stop().
+         */
+        void request_pause ( void )
+        {
+            std::lock_guard<std::mutex> lk(park_mtx);
+            if ( active.load(std::memory_order_acquire) )
+            {
+                pause_requested.store(true, std::memory_order_release);
+                stop_.request_stop();
+            }
+        }
+
+        /**
+         * @brief Aguarda a thread estacionar (ou a tarefa do pool terminar)
+         *
+         * Depois de retornar, run() não executa até resume(): o estado do
+         * estágio pode ser alterado sem concorrência.
+         */
+        void wait_paused ( void )
+        {
+            std::unique_lock<std::mutex> lk(park_mtx);
+            park_cv.wait(lk, [this] {
+                return !pause_requested.load(std::memory_order_acquire) || !active.load(std::memory_order_acquire) ||
+                       parked || (pool_ && !task_pending.load(std::memory_order_acquire));
+            });
+        }
+
+        /**
+         * @brief Pausa o laço e aguarda; a thread dedicada continua viva
+         */
+        void pause ( void )
+        {
+            request_pause();
+            wait_paused();
+        }
+
+        /**
+         * @brief Retoma o laço pausado
+         *
+         * A thread dedicada estacionada acorda; no pool a tarefa é agendada
+         * de novo. Sem efeito se não estiver pausado.
+         */
+        void resume ( void )
+        {
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
+            std::unique_lock<std::mutex> plk(park_mtx);
+            if ( !active.load(std::memory_order_acquire) || !pause_requested.load(std::memory_order_acquire) )
+                return;
+
+            // A pool task still finishing its run() must end before a new one is queued
+            if ( pool_ )
+                park_cv.wait(plk, [this] { return !task_pending.load(std::memory_order_acquire); });
+
+            stop_.reset();
+            pause_requested.store(false, std::memory_order_release);
+            if ( pool_ )
+            {
+                task_pending.store(true, std::memory_order_release);
+                pool_->submit([this] { pool_task(); });
+            }
+            else
+                park_cv.notify_all();
+        }
+
+        /// O laço está pausado (ou com pausa pedida); false depois de stop()
+        bool paused ( void ) const
+        {
+            return active.load(std::memory_order_acquire) && pause_requested.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Volta o estado do estágio ao de recém-construído
+         *
+         * Chamada pelo Pipeline com o estágio pausado ou parado. A
+         * implementação padrão não faz nada.
+         */
+        virtual void reset_state ( void ) {}
+
+        /**
+         * @brief Define as CPUs da thread dedicada
+         *
+         * Vale a partir do próximo start(); tarefas no thread_pool não são
+         * fixadas (os workers do pool são compartilhados).
+         *
+         * @param cpus lista de CPUs; vazia remove a afinidade
+         */
+        void set_affinity ( const std::vector<int> &cpus )
+        {
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
+            affinity_ = cpus;
+        }
+
+        /// CPUs configuradas por set_affinity()
+        std::vector<int> affinity ( void )
+        {
+            std::lock_guard<std::mutex> lk(lifecycle_mtx);
+            return affinity_;
+        }
+
+        /**
+         * @brief CPUs em que a thread dedicada pode executar, segundo o kernel
+         *
+         * Lidas de dentro da thread logo após aplicar set_affinity(); vazio
+         * antes disso, no thread_pool ou sem suporte a afinidade.
+         */
+        std::vector<int> running_cpus ( void )
+        {
+            std::lock_guard<std::mutex> lk(park_mtx);
+            return running_cpus_;
+        }
+
+        /**
+         * @brief Token acionado por stop() e request_pause()
+         *
+         * Para esperas e trabalho dentro de run() (ex.: workload), que
+         * devem terminar cedo quando o estágio é parado. Válido enquanto
+         * o estágio existir.
+         */
+        stop_token get_stop_token ( void ) const { return stop_.token(); }
+
+        /// Estágio cujo run() está executando na thread atual, ou nullptr
+        static thread_base *running ( void ) { return current(); }
+
+        /**
+         * @brief Caches de payload_pool do estágio (ver payload.h)
+         *
+         * No thread_pool as tarefas de um estágio mudam de worker; os caches
+         * ficam com o estágio para que os quadros liberados voltem ao
+         * produtor. Só o run() do próprio estágio os acessa.
+         */
+        payload_detail::thread_caches &payload_caches ( void ) { return payload_caches_; }
+
+        /**
+         * @brief Espera máxima por dados ou espaço dentro de run()
+         *
+         * stage_wait_timeout numa thread dedicada, pool_wait_timeout no
+         * thread_pool, onde a espera seguraria um worker compartilhado.
+         */
+        std::chrono::milliseconds wait_timeout ( void ) const
+        {
+            return pool_ ? pool_wait_timeout : stage_wait_timeout;
         }
 
         /**
          * @brief Verifica se a thread está ativa
          * 
          * @return true está ativa
-         * @return false não está ativa
+         * @return false não está ativa, ou pausa pedida
          */
         bool isActive ( void )
         {
-            return active.load(std::memory_order_acquire);
+            return active.load(std::memory_order_acquire) && !pause_requested.load(std::memory_order_acquire);
         }
 
         /**
@@ -105,4 +489,4 @@ class thread_base
         virtual void run ( void ) = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,72 @@
+#ifndef WAIT_STRATEGY_H
+#define WAIT_STRATEGY_H
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "bench_config.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/// How a thread waits on an event_count until the event (or the timeout)
+enum class wait_strategy {
+    spin,      // busy loop on the epoch; never sleeps (one core per waiter)
+    pause,     // busy loop with a pause/yield hint between checks
+    yield,     // short pause loop, then std::this_thread::yield() until the event
+    park,      // pause loop for park_spin_budget, then sleep on the condition variable (futex)
+    adaptive   // park, with a spin budget learned from how soon events arrived
+};
+
+// Spin phase of wait_strategy::park
+constexpr std::chrono::nanoseconds park_spin_budget{10000};
+
+// Bounds of the adaptive spin budget. Waits longer than the maximum are not
+// worth a core; the minimum keeps probing so short gaps are noticed again
+constexpr std::chrono::nanoseconds adaptive_spin_min{1000};
+constexpr std::chrono::nanoseconds adaptive_spin_max{50000};
+
+// Spin-wait hint: lets the sibling hyperthread run and saves power
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Spinning only helps when the notifier can run on another CPU
+inline bool spinning_pays_off()
+{
+    static const bool multi_cpu = std::thread::hardware_concurrency() > 1;
+    return multi_cpu;
+}
+
+// Next adaptive spin budget after a wait that had to park. notified: the event
+// arrived before the timeout; waited: time from the start of the wait until it
+// returned. An event that came soon after the spin gave up doubles the budget,
+// a long or expired wait halves it
+inline std::chrono::nanoseconds adapt_spin_budget(std::chrono::nanoseconds budget, bool notified,
+                                                  std::chrono::nanoseconds waited)
+{
+    if (notified && waited <= adaptive_spin_max)
+        budget = budget * 2;
+    else
+        budget = budget / 2;
+    if (budget < adaptive_spin_min) budget = adaptive_spin_min;
+    if (budget > adaptive_spin_max) budget = adaptive_spin_max;
+    return budget;
+}
+
+// Parse "spin", "pause", "yield", "park" or "adaptive"
+bool wait_strategy_from_string(const std::string &s, wait_strategy &strategy);
+const char *wait_strategy_name(wait_strategy strategy);
+
+// Strategy of the input channel of a stage as selected in cfg (adaptive
+// without cfg). Throws std::invalid_argument on an unknown name
+wait_strategy wait_strategy_for(const BenchConfig *cfg, const std::string &stage);
+
+#endif // WAIT_STRATEGY_H
@@ -0,0 +1,79 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench_config.h"
+#include "stop_token.h"
+
+/// Simulated work of a stage
+enum class workload_kind {
+    sleep,          // std::this_thread::sleep_for (no CPU use; original behaviour)
+    spin,           // dependent integer arithmetic (one core, no memory traffic)
+    hash,           // FNV-1a over an L1-resident block
+    memory,         // sequential read/write stream over the working set (bandwidth)
+    pointer_chase   // random dependent loads over the working set (latency)
+};
+
+// Default working set of the memory and pointer_chase kernels
+constexpr std::size_t default_workload_bytes = 8u << 20;
+
+/**
+ * @brief Executes a kernel for a requested amount of time
+ *
+ * CPU kernels do not read the clock while working: the iteration rate of
+ * each (kind, working set) is measured once per process and run(d) executes
+ * the matching number of iterations, so the work done is the same on every
+ * call. Each instance owns its working set; use one per stage instance.
+ * With a stop token, run() returns early once a stop is requested: sleeps
+ * wake up at once, CPU kernels check it every millisecond of work.
+ */
+class workload
+{
+    public:
+        explicit workload( workload_kind kind = workload_kind::sleep,
+                           std::size_t working_set_bytes = default_workload_bytes );
+
+        /// Kernel for a stage ("sA", "sB", "pcA", "pcB") as selected in cfg
+        static workload for_stage( const BenchConfig *cfg, const std::string &stage );
+
+        /// Parse "sleep", "spin", "hash", "memory" or "pointer_chase"
+        static bool kind_from_string( const std::string &s, workload_kind &kind );
+        static const char *kind_name( workload_kind kind );
+
+        void run( std::chrono::nanoseconds d );
+
+        /// Token that cuts run() short (default: never)
+        void set_stop_token( const stop_token &token ) { stop_ = token; }
+
+        /// Kernel iterations run(d) performs for d
+        std::uint64_t iterations_for( std::chrono::nanoseconds d ) const;
+
+        workload_kind kind( void ) const { return kind_; }
+
+    private:
+        void prepare( void );
+        void calibrate( void );
+        void step( std::uint64_t iters );
+
+        workload_kind kind_;
+        std::size_t bytes_;
+
+        /// Working set (memory/pointer_chase) or hash block
+        std::vector<std::uint64_t> data_;
+        std::size_t cursor_ = 0;
+
+        /// Kernel state, kept between calls so the compiler cannot drop the work
+        std::uint64_t state_ = 0x9e3779b97f4a7c15ULL;
+
+        /// Measured cost of one iteration
+        double ns_per_iter_ = 1.0;
+
+        stop_token stop_;
+};
+
+#endif // WORKLOAD_H
@@ -3,12 +3,12 @@ set -e
 OUTDIR="${PWD}/outputs"
 mkdir -p "$OUTDIR"
 OUTCSV="$OUTDIR/results.csv"
-PROFILE="$OUTDIR/profile_events.csv"
+PROFILE="$OUTDIR/profile_events.bin"
 
-# Results header (overwrite file)
-echo "threads,duration_s,work_us,run,processed,throughput_items_s" > "$OUTCSV"
-# Create/clear profile events file with header
-echo "thread,time,status" > "$PROFILE"
+# Results file (overwrite); the program writes the header, including latency columns
+rm -f "$OUTCSV"
+# Clear binary profile trace (each run appends a segment)
+rm -f "$PROFILE"
 
 BIN="${PWD}/build/pipelines_cpp"
 if [ ! -x "$BIN" ]; then
@@ -28,10 +28,13 @@ for t in "${THREADS_LIST[@]}"; do
     for d in "${DURATION_LIST[@]}"; do
       echo "Running bench: threads=$t work_us=$w duration=$d"
       # Program prints a couple header lines; filter them out and append data
-      "$BIN" --threads "$t" --duration "$d" --work-us "$w" --warmup "$WARMUP" --repeats "$REPEATS" --seed 42 --out "$OUTCSV" --profile "$OUTDIR/profile_events.csv" >/dev/null
-      # program writes results to $OUTCSV and profile events to $OUTDIR/profile_events.csv
+      "$BIN" --threads "$t" --consumers "$t" --duration "$d" --work-us "$w" --warmup "$WARMUP" --repeats "$REPEATS" --seed 42 --out "$OUTCSV" --profile "$PROFILE" >/dev/null
+      # program writes results to $OUTCSV and profile events to $PROFILE
     done
   done
 done
 
+# CSV timeline for bench/grafico.py
+"${PWD}/build/profile_convert" "$PROFILE" "$OUTDIR/profile_events.csv"
+
 echo "Bench finished, results -> $OUTCSV"
@@ -0,0 +1,42 @@
+#include "backpressure.h"
+#include <stdexcept>
+
+bool overflow_policy_from_string(const std::string &s, overflow_policy &policy)
+{
+    if (s == "block") policy = overflow_policy::block;
+    else if (s == "drop_newest") policy = overflow_policy::drop_newest;
+    else if (s == "drop_oldest") policy = overflow_policy::drop_oldest;
+    else if (s == "sample") policy = overflow_policy::sample;
+    else return false;
+    return true;
+}
+
+const char *overflow_policy_name(overflow_policy policy)
+{
+    switch (policy) {
+    case overflow_policy::block: return "block";
+    case overflow_policy::drop_newest: return "drop_newest";
+    case overflow_policy::drop_oldest: return "drop_oldest";
+    case overflow_policy::sample: return "sample";
+    }
+    return "?";
+}
+
+std::string edge_key(const std::string &from, const std::string &to)
+{
+    return from + ":" + to;
+}
+
+overflow_policy overflow_policy_for(const BenchConfig *cfg, const std::string &from, const std::string &to)
+{
+    if (!cfg) return overflow_policy::block;
+
+    std::string name = cfg->backpressure;
+    auto it = cfg->edge_backpressure.find(edge_key(from, to));
+    if (it != cfg->edge_backpressure.end()) name = it->second;
+
+    overflow_policy policy;
+    if (!overflow_policy_from_string(name, policy))
+        throw std::invalid_argument("unknown backpressure policy '" + name + "' for edge " + edge_key(from, to));
+    return policy;
+}
@@ -0,0 +1,184 @@
+#include "cpu_affinity.h"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <thread>
+
+#if CPU_AFFINITY_SUPPORTED
+#include <pthread.h>
+#include <sched.h>
+
+static_assert(max_cpus == CPU_SETSIZE, "max_cpus must match cpu_set_t");
+#endif
+
+namespace {
+// First integer of a sysfs file, or fallback
+int read_int(const std::string &path, int fallback)
+{
+    std::ifstream in(path);
+    int v;
+    return (in >> v) ? v : fallback;
+}
+
+std::string read_line(const std::string &path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// CPUs the process may run on
+std::vector<int> allowed_cpus()
+{
+    std::vector<int> cpus;
+#if CPU_AFFINITY_SUPPORTED
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned n = std::thread::hardware_concurrency();
+        for (unsigned c = 0; c < (n ? n : 1); c++) cpus.push_back((int)c);
+    }
+    return cpus;
+}
+}
+
+bool parse_cpu_list(const std::string &s, std::vector<int> &cpus)
+{
+    std::vector<int> out;
+    std::size_t pos = 0;
+    while (pos < s.size()) {
+        std::size_t comma = s.find(',', pos);
+        std::string item = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = comma == std::string::npos ? s.size() : comma + 1;
+
+        char *end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || end == item.c_str() || first < 0) return false;
+        long last = first;
+        if (*end == '-') {
+            const char *start = end + 1;
+            last = std::strtol(start, &end, 10);
+            if (end == start || last < first) return false;
+        }
+        if (*end != '\0' || last >= max_cpus) return false;
+        for (long c = first; c <= last; c++) out.push_back((int)c);
+    }
+    if (out.empty()) return false;
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    cpus = out;
+    return true;
+}
+
+cpu_topology cpu_topology::detect()
+{
+    cpu_topology t;
+    for (int c : allowed_cpus()) {
+        const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/";
+        cpu_info info;
+        info.cpu = c;
+        info.core = read_int(dir + "core_id", c);
+        info.package = read_int(dir + "physical_package_id", 0);
+        info.node = 0;
+        t.cpus_.push_back(info);
+    }
+
+    // Node of each CPU, from the node cpulists
+    std::vector<int> nodes;
+    if (parse_cpu_list(read_line("/sys/devices/system/node/online"), nodes)) {
+        for (int n : nodes) {
+            std::vector<int> node_cpus;
+            if (!parse_cpu_list(read_line("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist"), node_cpus))
+                continue;
+            for (auto &info : t.cpus_) {
+                if (std::binary_search(node_cpus.begin(), node_cpus.end(), info.cpu)) info.node = n;
+            }
+        }
+    }
+    return t;
+}
+
+int cpu_topology::node_count() const
+{
+    std::vector<int> nodes;
+    for (const auto &info : cpus_) nodes.push_back(info.node);
+    std::sort(nodes.begin(), nodes.end());
+    return (int)(std::unique(nodes.begin(), nodes.end()) - nodes.begin());
+}
+
+int cpu_topology::node_of(int cpu) const
+{
+    for (const auto &info : cpus_) {
+        if (info.cpu == cpu) return info.node;
+    }
+    return -1;
+}
+
+std::vector<int> cpu_topology::placement_order() const
+{
+    std::vector<cpu_info> sorted = cpus_;
+    std::sort(sorted.begin(), sorted.end(), [](const cpu_info &a, const cpu_info &b) {
+        if (a.node != b.node) return a.node < b.node;
+        if (a.package != b.package) return a.package < b.package;
+        if (a.core != b.core) return a.core < b.core;
+        return a.cpu < b.cpu;
+    });
+
+    std::vector<int> order;
+    for (const auto &info : sorted) order.push_back(info.cpu);
+    return order;
+}
+
+bool pin_current_thread(const std::vector<int> &cpus)
+{
+    if (cpus.empty()) return true;
+#if CPU_AFFINITY_SUPPORTED
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+std::vector<int> current_thread_cpus()
+{
+    std::vector<int> cpus;
+#if CPU_AFFINITY_SUPPORTED
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+void run_pinned(const std::vector<int> &cpus, const std::function<void()> &fn)
+{
+    std::exception_ptr error;
+    std::thread t([&] {
+        pin_current_thread(cpus);
+        try {
+            fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+    t.join();
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,43 @@
+#include "latency_histogram.h"
+#include <cmath>
+
+constexpr unsigned latency_histogram::sub_bits;
+constexpr std::size_t latency_histogram::sub_buckets;
+constexpr std::size_t latency_histogram::bucket_count;
+
+unsigned long long latency_histogram::bucket_upper(std::size_t idx)
+{
+    if (idx < 2 * sub_buckets) return idx;
+    unsigned shift = (unsigned)(idx / sub_buckets) - 1;
+    unsigned long long mantissa = idx % sub_buckets + sub_buckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+long long latency_histogram::percentile(double q) const
+{
+    unsigned long long total = count();
+    if (total == 0) return 0;
+
+    // Rank of the sample (1-based) the percentile falls on
+    unsigned long long rank = (unsigned long long)std::ceil(q * (double)total);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    long long m = max();
+    unsigned long long seen = 0;
+    for (std::size_t i = 0; i < bucket_count; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            long long upper = (long long)bucket_upper(i);
+            return upper < m ? upper : m;
+        }
+    }
+    return m;
+}
+
+void latency_histogram::reset()
+{
+    for (auto &b : buckets_) b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
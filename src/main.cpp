@@ -1,16 +1,96 @@
 #include <iostream>
+#include <fstream>
+#include <csignal>
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 
 #include "pipeline.h"
 #include "bench_config.h"
 #include "bench_metrics.h"
 #include "profile_print.h"
+#include "workload.h"
+#include "run_window.h"
 
 static void print_usage(const char *prog)
 {
-    printf("Usage: %s --out RESULTS.csv --profile PROFILE.csv [--duration S] [--work-us US] [--warmup N] [--repeats R] [--seed S]\n", prog);
+    printf("Usage: %s --out RESULTS.csv --profile PROFILE.csv [--duration S] [--work-us US] [--warmup N] [--repeats R] [--seed S]\n"
+           "          [--duration-ms MS] [--warm-in-ms MS] [--interval-ms MS]\n"
+           "          [--producers N] [--consumers N] [--queue-capacity N] [--batch-size N]\n"
+           "          [--executor pool|dedicated] [--threads N] [--profile-format binary|csv]\n"
+           "          [--profile-clock steady|tsc] [--pipeline FILE]\n"
+           "          [--profile-sample N] [--profile-capture-ms MS] [--profile-budget N] [--profile-report FILE|-]\n"
+           "          [--workload KIND] [--stage-workload STAGE=KIND]... [--workload-bytes N]\n"
+           "          [--affinity none|auto] [--stage-affinity STAGE=CPUS]...\n"
+           "          [--wait WAIT] [--channel-wait STAGE=WAIT]...\n"
+           "          [--backpressure POLICY] [--edge-backpressure FROM:TO=POLICY]... [--sample-every N]\n"
+           "          [--shutdown cancel|drain]\n"
+           "          KIND: sleep|spin|hash|memory|pointer_chase  STAGE: sA|sB|pcA|pcB  CPUS: 0-3,8\n"
+           "          WAIT: spin|pause|yield|park|adaptive  POLICY: block|drop_newest|drop_oldest|sample\n", prog);
+}
+
+// SIGUSR1: open a profile capture window (--profile-capture-ms)
+static void on_capture_signal(int)
+{
+    ProfilePrinter::trigger_capture_from_signal();
+}
+
+// Latency columns of the results CSV: p50/p99/p999/max (microseconds) per histogram
+static std::string latency_header()
+{
+    const char *names[] = { "sA", "sB", "pcA", "pcB", "e2e" };
+    std::string h;
+    for(const char *n : names)
+    {
+        for(const char *stat : { "p50", "p99", "p999", "max" })
+            h += std::string(",") + n + "_" + stat + "_us";
+    }
+    return h;
+}
+
+static std::string latency_values(const pipeline_metrics &m)
+{
+    const latency_histogram *hists[] = { &m.sA, &m.sB, &m.pcA, &m.pcB, &m.end_to_end };
+    std::string v;
+    char buf[64];
+    for(const latency_histogram *h : hists)
+    {
+        snprintf(buf, sizeof(buf), ",%.1f,%.1f,%.1f,%.1f",
+                 h->percentile(0.50) / 1e3, h->percentile(0.99) / 1e3,
+                 h->percentile(0.999) / 1e3, h->max() / 1e3);
+        v += buf;
+    }
+    return v;
+}
+
+// Frame allocation columns of the results CSV (frame_A + frame_B slabs)
+static std::string frame_header()
+{
+    return ",frames_capacity,frames_acquired,frames_remote_frees,frames_heap_allocs";
+}
+
+static std::string frame_values(const payload_pool_stats &s)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), ",%zu,%llu,%llu,%llu", s.capacity, (unsigned long long)s.acquired,
+             (unsigned long long)s.remote_frees, (unsigned long long)s.heap_allocs);
+    return buf;
+}
+
+// Full-queue columns of the results CSV, summed over all queues
+static std::string backpressure_header()
+{
+    return ",producer_waits,drops_newest,drops_oldest,drops_sampled";
+}
+
+static std::string backpressure_values(const backpressure_stats &s)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), ",%llu,%llu,%llu,%llu", (unsigned long long)s.blocked,
+             (unsigned long long)s.dropped_newest, (unsigned long long)s.dropped_oldest,
+             (unsigned long long)s.sampled_out);
+    return buf;
 }
 
 int main(int argc, char** argv)
@@ -21,23 +101,154 @@ int main(int argc, char** argv)
     // Simple manual parsing
     for(int i=1;i<argc;i++){
         if(strcmp(argv[i],"--duration")==0 && i+1<argc){ benchConfig.duration_s = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--duration-ms")==0 && i+1<argc){ benchConfig.duration_ms = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--warm-in-ms")==0 && i+1<argc){ benchConfig.warm_in_ms = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--interval-ms")==0 && i+1<argc){ benchConfig.interval_ms = atoi(argv[++i]); }
         else if(strcmp(argv[i],"--work-us")==0 && i+1<argc){ benchConfig.work_us = atoi(argv[++i]); }
         else if(strcmp(argv[i],"--warmup")==0 && i+1<argc){ benchConfig.warmup = atoi(argv[++i]); }
         else if(strcmp(argv[i],"--repeats")==0 && i+1<argc){ benchConfig.repeats = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--shutdown")==0 && i+1<argc){ benchConfig.shutdown = std::string(argv[++i]); }
         else if(strcmp(argv[i],"--seed")==0 && i+1<argc){ benchConfig.seed = (unsigned int)atoi(argv[++i]); }
         else if(strcmp(argv[i],"--out")==0 && i+1<argc){ benchConfig.out_file = std::string(argv[++i]); }
         else if(strcmp(argv[i],"--profile")==0 && i+1<argc){ benchConfig.profile_file = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-format")==0 && i+1<argc){ benchConfig.profile_format = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-clock")==0 && i+1<argc){ benchConfig.profile_clock = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-sample")==0 && i+1<argc){ benchConfig.profile_sample_every = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-capture-ms")==0 && i+1<argc){ benchConfig.profile_capture_ms = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-budget")==0 && i+1<argc){ benchConfig.profile_budget = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--profile-report")==0 && i+1<argc){ benchConfig.profile_report = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--pipeline")==0 && i+1<argc){ benchConfig.pipeline_file = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--workload")==0 && i+1<argc){ benchConfig.workload = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--workload-bytes")==0 && i+1<argc){ benchConfig.workload_bytes = (std::size_t)atoll(argv[++i]); }
+        else if(strcmp(argv[i],"--stage-workload")==0 && i+1<argc){
+            std::string arg(argv[++i]);
+            std::size_t eq = arg.find('=');
+            if(eq == std::string::npos){ printf("Error: --stage-workload expects STAGE=KIND\n"); return 1; }
+            benchConfig.stage_workloads[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+        else if(strcmp(argv[i],"--affinity")==0 && i+1<argc){ benchConfig.affinity = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--stage-affinity")==0 && i+1<argc){
+            std::string arg(argv[++i]);
+            std::size_t eq = arg.find('=');
+            if(eq == std::string::npos){ printf("Error: --stage-affinity expects STAGE=CPUS\n"); return 1; }
+            benchConfig.stage_affinity[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+        else if(strcmp(argv[i],"--wait")==0 && i+1<argc){ benchConfig.wait_strategy = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--channel-wait")==0 && i+1<argc){
+            std::string arg(argv[++i]);
+            std::size_t eq = arg.find('=');
+            if(eq == std::string::npos){ printf("Error: --channel-wait expects STAGE=WAIT\n"); return 1; }
+            benchConfig.channel_waits[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+        else if(strcmp(argv[i],"--backpressure")==0 && i+1<argc){ benchConfig.backpressure = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--sample-every")==0 && i+1<argc){ benchConfig.sample_every = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--edge-backpressure")==0 && i+1<argc){
+            std::string arg(argv[++i]);
+            std::size_t eq = arg.find('=');
+            if(eq == std::string::npos){ printf("Error: --edge-backpressure expects FROM:TO=POLICY\n"); return 1; }
+            benchConfig.edge_backpressure[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
         else if(strcmp(argv[i],"--threads")==0 && i+1<argc){ benchConfig.threads = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--producers")==0 && i+1<argc){ benchConfig.producers = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--consumers")==0 && i+1<argc){ benchConfig.consumers = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--queue-capacity")==0 && i+1<argc){ benchConfig.queue_capacity = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--batch-size")==0 && i+1<argc){ benchConfig.batch_size = atoi(argv[++i]); }
+        else if(strcmp(argv[i],"--executor")==0 && i+1<argc){ benchConfig.executor = std::string(argv[++i]); }
         else if(strcmp(argv[i],"--help")==0){ print_usage(argv[0]); return 0; }
         else { printf("Unknown arg: %s\n", argv[i]); print_usage(argv[0]); return 1; }
     }
 
+    if( benchConfig.executor != "pool" && benchConfig.executor != "dedicated" )
+    {
+        printf("Error: --executor must be 'pool' or 'dedicated'\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    stop_mode shutdown;
+    if( !stop_mode_from_string(benchConfig.shutdown, shutdown) )
+    {
+        printf("Error: --shutdown must be 'cancel' or 'drain'\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if( !benchConfig.profile_format.empty() && benchConfig.profile_format != "binary" && benchConfig.profile_format != "csv" )
+    {
+        printf("Error: --profile-format must be 'binary' or 'csv'\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if( benchConfig.profile_clock != "steady" && benchConfig.profile_clock != "tsc" )
+    {
+        printf("Error: --profile-clock must be 'steady' or 'tsc'\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if( benchConfig.profile_sample_every < 0 || benchConfig.profile_capture_ms < 0 || benchConfig.profile_budget < 0 )
+    {
+        printf("Error: --profile-sample, --profile-capture-ms and --profile-budget must not be negative\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    workload_kind kind;
+    if( !workload::kind_from_string(benchConfig.workload, kind) )
+    {
+        printf("Error: unknown workload '%s'\n", benchConfig.workload.c_str());
+        print_usage(argv[0]);
+        return 1;
+    }
+    for( const auto &sw : benchConfig.stage_workloads )
+    {
+        bool known_stage = sw.first == "sA" || sw.first == "sB" || sw.first == "pcA" || sw.first == "pcB";
+        if( !known_stage || !workload::kind_from_string(sw.second, kind) )
+        {
+            printf("Error: invalid --stage-workload '%s=%s'\n", sw.first.c_str(), sw.second.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Report topology errors before any run
+    if( !benchConfig.pipeline_file.empty() )
+    {
+        try
+        {
+            PipelineBuilder::from_file(benchConfig.pipeline_file, &benchConfig).validate();
+        }
+        catch( const std::exception &e )
+        {
+            printf("Error: pipeline '%s': %s\n", benchConfig.pipeline_file.c_str(), e.what());
+            return 1;
+        }
+    }
+
+    // Report affinity, wait strategy and backpressure errors (modes, CPU lists, stage and edge names) before any run
+    try
+    {
+        PipelineBuilder spec = benchConfig.pipeline_file.empty()
+            ? PipelineBuilder::standard(&benchConfig)
+            : PipelineBuilder::from_file(benchConfig.pipeline_file, &benchConfig);
+        spec.placement(cpu_topology::detect());
+        spec.wait_strategies();
+        spec.edge_policies();
+    }
+    catch( const std::exception &e )
+    {
+        printf("Error: %s\n", e.what());
+        print_usage(argv[0]);
+        return 1;
+    }
+
     if( benchConfig.seed != 0 ) srand(benchConfig.seed);
 
-    // Require both output files: results CSV and profile events
-    if( benchConfig.out_file.empty() || benchConfig.profile_file.empty() )
+    // Require the results CSV and some profile output: raw events, the zone report or both
+    if( benchConfig.out_file.empty() || (benchConfig.profile_file.empty() && benchConfig.profile_report.empty()) )
     {
-        printf("Error: both --out and --profile must be specified.\n");
+        printf("Error: both --out and --profile (or --profile-report) must be specified.\n");
         print_usage(argv[0]);
         return 1;
     }
@@ -53,41 +264,101 @@ int main(int argc, char** argv)
             long size = ftell(f);
             if(size == 0)
             {
-                fprintf(f, "threads,duration_s,work_us,run,processed,throughput_items_s\n");
+                fprintf(f, "threads,duration_s,work_us,run,processed,throughput_items_s%s%s%s,window_s\n", latency_header().c_str(),
+                        frame_header().c_str(), backpressure_header().c_str());
             }
             fclose(f);
         }
     }
 
+    // Clock first: the profile file header already carries a timestamp
+    if( benchConfig.profile_clock == "tsc" && !ProfilePrinter::get().set_clock(profile_clock_source::tsc) )
+    {
+        printf("Warning: invariant TSC not available, using steady_clock for profiling\n");
+    }
+
     // Open profile file via ProfilePrinter
-    if (!ProfilePrinter::get().open_file(benchConfig.profile_file)) {
+    profile_format pformat = ProfilePrinter::format_for(benchConfig.profile_file);
+    if (benchConfig.profile_format == "binary") pformat = profile_format::binary;
+    else if (benchConfig.profile_format == "csv") pformat = profile_format::csv;
+    if (!benchConfig.profile_file.empty() && !ProfilePrinter::get().open_file(benchConfig.profile_file, pformat)) {
         printf("Error: cannot open profile file '%s' for writing\n", benchConfig.profile_file.c_str());
         return 1;
     }
 
+    // Sampled profiling for long runs; with a capture window, each measured
+    // window opens a capture and SIGUSR1 opens one on demand
+    profile_sampling sampling;
+    sampling.sample_every = (unsigned)benchConfig.profile_sample_every;
+    sampling.capture_ms = benchConfig.profile_capture_ms;
+    sampling.budget_per_s = (unsigned)benchConfig.profile_budget;
+    ProfilePrinter::get().set_sampling(sampling);
+    const bool capture = sampling.capture_ms > 0;
+    if( capture )
+        std::signal(SIGUSR1, on_capture_signal);
+
+    // Zone aggregates cover the measured windows only
+    const bool report = !benchConfig.profile_report.empty();
+
+    // Measured window: warm-in, then steady_clock snapshots of the counters
+    const run_window window = run_window::from_config(&benchConfig);
+    const double nominal_s = std::chrono::duration<double>(window.measure).count();
+
+    // One Pipeline for every run: between runs the stage threads are parked
+    // and the stage state is reset in place instead of rebuilt
+    Pipeline mt(&benchConfig);
+    bool started = false;
+    auto begin_run = [&]{
+        if( started )
+        {
+            mt.reset();
+            reset_processed_items();
+            mt.resume();
+        }
+        else
+        {
+            reset_processed_items();
+            mt.start();
+            started = true;
+        }
+    };
+
     // Warmup runs
     for(int w=0; w<benchConfig.warmup; ++w)
     {
-        reset_processed_items();
-        Pipeline mt;
-        mt.start();
-        std::this_thread::sleep_for(std::chrono::seconds(benchConfig.duration_s));
-        mt.stop();
+        begin_run();
+        window.run(get_processed_items);
+        mt.pause();
         printf("warmup %d done\n", w+1);
     }
 
     // Repeat benchmark runs
     for(int r=1; r<=benchConfig.repeats; ++r)
     {
-        reset_processed_items();
-        Pipeline mt;
-        mt.start();
-        std::this_thread::sleep_for(std::chrono::seconds(benchConfig.duration_s));
-        mt.stop();
+        backpressure_stats drops_at_open;
+        payload_pool_stats frames_at_open;
+        begin_run();
+        window_result measured = window.run(get_processed_items,
+            [&]{
+                mt.reset_metrics(); drops_at_open = mt.backpressure(); frames_at_open = mt.frame_stats();
+                if( capture ) ProfilePrinter::get().trigger_capture();
+                if( report ) ProfilePrinter::get().set_aggregation(true);
+            },
+            [&](const interval_sample &s){
+                printf("interval run=%d #%d t=%.3fs processed=%lld throughput=%.2f items/s\n",
+                       r, s.index, s.end_s, s.processed, s.items_per_s);
+                fflush(stdout);
+            });
+        if( report ) ProfilePrinter::get().set_aggregation(false);
+        backpressure_stats window_drops = mt.backpressure().since(drops_at_open);
+        payload_pool_stats window_frames = mt.frame_stats().since(frames_at_open);
+        std::string latencies = latency_values(mt.metrics());
+        mt.pause();
 
-        long long processed = get_processed_items();
-        double throughput = 0.0;
-        if(benchConfig.duration_s > 0) throughput = (double)processed / (double)benchConfig.duration_s;
+        long long processed = measured.processed;
+        std::string frames = frame_values(window_frames);
+        std::string drops = backpressure_values(window_drops);
+        double throughput = measured.items_per_s;
 
         // Write to file if requested, else to stdout
         if( !benchConfig.out_file.empty() )
@@ -95,7 +366,7 @@ int main(int argc, char** argv)
             FILE *f = fopen(benchConfig.out_file.c_str(), "a");
             if(f)
             {
-                fprintf(f, "%d,%d,%d,%d,%lld,%.2f\n", benchConfig.threads, benchConfig.duration_s, benchConfig.work_us, r, processed, throughput);
+                fprintf(f, "%d,%g,%d,%d,%lld,%.2f%s%s%s,%.6f\n", benchConfig.threads, nominal_s, benchConfig.work_us, r, processed, throughput, latencies.c_str(), frames.c_str(), drops.c_str(), measured.elapsed_s);
                 fclose(f);
             }
             else
@@ -105,9 +376,37 @@ int main(int argc, char** argv)
         }
         else
         {
-            printf("%d,%d,%d,%d,%lld,%.2f\n", benchConfig.threads, benchConfig.duration_s, benchConfig.work_us, r, processed, throughput);
+            printf("%d,%g,%d,%d,%lld,%.2f%s%s%s,%.6f\n", benchConfig.threads, nominal_s, benchConfig.work_us, r, processed, throughput, latencies.c_str(), frames.c_str(), drops.c_str(), measured.elapsed_s);
+        }
+    }
+
+    // Shut down a running pipeline, so the latency is that of stopping real work
+    mt.resume();
+    shutdown_report down = mt.stop(shutdown);
+    printf("shutdown mode=%s latency=%.3fms drain=%.3fms discarded=%zu%s\n", stop_mode_name(shutdown),
+           down.latency.count() / 1e6, down.drain.count() / 1e6, down.discarded,
+           down.drain_timed_out ? " (drain timed out)" : "");
+
+    if( report )
+    {
+        zone_report zones = ProfilePrinter::get().zone_stats();
+        if( benchConfig.profile_report == "-" )
+        {
+            write_zone_report(std::cout, zones);
+        }
+        else
+        {
+            std::ofstream rep(benchConfig.profile_report);
+            if( rep ) write_zone_report(rep, zones);
+            else printf("error opening profile report %s\n", benchConfig.profile_report.c_str());
         }
     }
 
+    const profile_sampling_stats skipped = ProfilePrinter::get().sampling_stats();
+    if( skipped.sampled_out || skipped.outside_capture || skipped.over_budget )
+    {
+        printf("profile zones skipped: sampled_out=%llu outside_capture=%llu over_budget=%llu\n",
+               skipped.sampled_out, skipped.outside_capture, skipped.over_budget);
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "pipeline.h"
+#include "mpmc_queue.h"
+#include "spsc_ring.h"
+#include "cpu_affinity.h"
+#include <functional>
+#include <thread>
+
+namespace {
+// SPSC ring for a point-to-point edge, MPMC queue when shared on either side
+// or when producers evict (drop_oldest)
+template <typename T>
+channel<T> *make_queue(std::vector<std::unique_ptr<channel<T>>> &owned, int producers, int consumers, bool evict,
+                       BenchConfig *cfg)
+{
+    if (producers == 1 && consumers == 1 && !evict)
+        owned.emplace_back(new spsc_ring<T>(queue_capacity_of(cfg)));
+    else
+        owned.emplace_back(new mpmc_queue<T>(queue_capacity_of(cfg)));
+    owned.back()->set_sample_every(sample_every_of(cfg));
+    return owned.back().get();
+}
+
+// Signals every instance before waiting for any, so they wind down together
+template <typename S>
+void finish_all(const std::vector<std::unique_ptr<S>> &instances)
+{
+    for (const auto &s : instances) s->request_finish();
+    for (const auto &s : instances) s->finish();
+}
+
+template <typename T>
+bool wait_empty(const std::vector<std::unique_ptr<channel<T>>> &queues, std::chrono::steady_clock::time_point deadline)
+{
+    for (const auto &q : queues) {
+        while (!q->empty()) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+}
+
+bool stop_mode_from_string(const std::string &s, stop_mode &mode)
+{
+    if (s == "cancel") mode = stop_mode::cancel;
+    else if (s == "drain") mode = stop_mode::drain;
+    else return false;
+    return true;
+}
+
+const char *stop_mode_name(stop_mode mode)
+{
+    return mode == stop_mode::drain ? "drain" : "cancel";
+}
+
+Pipeline::Pipeline(const PipelineBuilder &spec)
+{
+    spec.validate();
+
+    BenchConfig *cfg = spec.config();
+    if (cfg && cfg->executor == "pool")
+        pool.reset(new thread_pool(cfg->threads > 0 ? (std::size_t)cfg->threads : 0));
+
+    const auto &specs = spec.stages();
+    const auto &edges = spec.edges();
+
+    // Producer instances feeding each stage (through all of its edges), and
+    // whether any of them evicts from the stage's queue
+    std::vector<overflow_policy> policies = spec.edge_policies();
+    std::vector<int> feeders(specs.size(), 0);
+    std::vector<bool> evict(specs.size(), false);
+    for (std::size_t j = 0; j < edges.size(); j++) {
+        int to = spec.find(edges[j].to);
+        feeders[to] += specs[spec.find(edges[j].from)].instances;
+        if (policies[j] == overflow_policy::drop_oldest) evict[to] = true;
+    }
+
+    // CPUs of each stage instance; the topology is only read when asked for
+    bool pinned = cfg && (cfg->affinity != "none" || !cfg->stage_affinity.empty());
+    cpu_topology topo;
+    if (pinned) topo = cpu_topology::detect();
+    std::vector<std::vector<std::vector<int>>> cpus = spec.placement(topo);
+    std::vector<wait_strategy> waits = spec.wait_strategies();
+
+    // One input queue per consumer stage, shared by its instances. On a NUMA
+    // machine the queue is built (first touched) from the consumer's CPUs, so
+    // its slots live on the node that reads them
+    bool numa = pinned && topo.node_count() > 1;
+    std::vector<channel<item_A> *> in_A(specs.size(), nullptr);
+    std::vector<channel<item_B> *> in_B(specs.size(), nullptr);
+    for (std::size_t i = 0; i < specs.size(); i++) {
+        std::function<void()> make;
+        if (specs[i].kind == stage_kind::process_A || specs[i].kind == stage_kind::source_B)
+            make = [&, i] { in_A[i] = make_queue(queues_A, feeders[i], specs[i].instances, evict[i], cfg); };
+        else if (specs[i].kind == stage_kind::process_B)
+            make = [&, i] { in_B[i] = make_queue(queues_B, feeders[i], specs[i].instances, evict[i], cfg); };
+        else
+            continue;
+
+        if (numa && !cpus[i].empty() && !cpus[i][0].empty())
+            run_pinned(cpus[i][0], make);
+        else
+            make();
+        if (in_A[i]) in_A[i]->set_wait_strategy(waits[i]);
+        if (in_B[i]) in_B[i]->set_wait_strategy(waits[i]);
+    }
+
+    // Frames alive at once: every queue full plus an input and an output batch
+    // per instance. Slabs of that size keep acquire() off the heap after start()
+    std::size_t frames_in_A = 0, frames_in_B = 0, held = 0;
+    for (const auto &q : queues_A) frames_in_A += q->capacity();
+    for (const auto &q : queues_B) frames_in_B += q->capacity();
+    for (const auto &s : specs) held += (std::size_t)s.instances;
+    held *= 2 * batch_size_of(cfg);
+    frames_A.reset(new payload_pool<frame_A>(frames_in_A + held));
+    frames_B.reset(new payload_pool<frame_B>(frames_in_B + held));
+
+    for (std::size_t i = 0; i < specs.size(); i++) {
+        for (int k = 0; k < specs[i].instances; k++) {
+            switch (specs[i].kind) {
+            case stage_kind::source_A: {
+                source_A *s = new source_A(cfg);
+                sources_A.emplace_back(s);
+                s->set_frames(frames_A.get());
+                s->set_wait_strategy(waits[i]);
+                for (std::size_t j = 0; j < edges.size(); j++) {
+                    if (edges[j].from == specs[i].name) s->attach(in_A[spec.find(edges[j].to)], policies[j]);
+                }
+                s->set_metrics(&metrics_);
+                stages.push_back(s);
+                break;
+            }
+            case stage_kind::source_B: {
+                source_B *s = new source_B(in_A[i], cfg);
+                sources_B.emplace_back(s);
+                s->set_frames(frames_B.get());
+                s->set_wait_strategy(waits[i]);
+                for (std::size_t j = 0; j < edges.size(); j++) {
+                    if (edges[j].from == specs[i].name) s->attach(in_B[spec.find(edges[j].to)], policies[j]);
+                }
+                s->set_metrics(&metrics_);
+                stages.push_back(s);
+                break;
+            }
+            case stage_kind::process_A: {
+                process_A *p = new process_A(in_A[i], cfg);
+                processes_A.emplace_back(p);
+                p->set_metrics(&metrics_);
+                stages.push_back(p);
+                break;
+            }
+            case stage_kind::process_B: {
+                process_B *p = new process_B(in_B[i], cfg);
+                processes_B.emplace_back(p);
+                p->set_metrics(&metrics_);
+                stages.push_back(p);
+                break;
+            }
+            }
+            stages.back()->set_affinity(cpus[i][k]);
+        }
+    }
+}
+
+void Pipeline::reset(void)
+{
+    item_A a;
+    for (auto &q : queues_A) {
+        while (q->try_pop(a)) a.reset();
+    }
+    item_B b;
+    for (auto &q : queues_B) {
+        while (q->try_pop(b)) b.reset();
+    }
+
+    for (auto *stage : stages)
+        stage->reset_state();
+    metrics_.reset();
+}
+
+shutdown_report Pipeline::stop(stop_mode mode, std::chrono::milliseconds drain_timeout)
+{
+    typedef std::chrono::steady_clock clock;
+    shutdown_report r;
+    const clock::time_point t0 = clock::now();
+
+    if (mode == stop_mode::drain) {
+        // Item types fix the layers: source_A feeds process_A and source_B,
+        // source_B feeds process_B. A layer is finished once everything
+        // upstream has stopped and its input queues are empty
+        const clock::time_point deadline = t0 + drain_timeout;
+        resume();
+        finish_all(sources_A);
+        bool drained = wait_empty(queues_A, deadline);
+        if (drained) {
+            finish_all(processes_A);
+            finish_all(sources_B);
+            drained = wait_empty(queues_B, deadline);
+        }
+        if (drained) finish_all(processes_B);
+        r.drain_timed_out = !drained;
+        r.drain = clock::now() - t0;
+    }
+
+    for (auto *stage : stages)
+        stage->request_stop();
+    for (auto &q : queues_A) q->wake_all();
+    for (auto &q : queues_B) q->wake_all();
+    for (auto *stage : stages)
+        stage->stop();
+
+    r.latency = clock::now() - t0;
+    for (const auto &q : queues_A) r.discarded += q->size();
+    for (const auto &q : queues_B) r.discarded += q->size();
+    return r;
+}
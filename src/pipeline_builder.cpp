@@ -0,0 +1,280 @@
+#include "pipeline_builder.h"
+#include "pipeline.h"
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// Item type a stage produces / consumes: 'A', 'B' or 0 (none)
+char output_of(stage_kind kind)
+{
+    switch (kind) {
+    case stage_kind::source_A: return 'A';
+    case stage_kind::source_B: return 'B';
+    default: return 0;
+    }
+}
+
+char input_of(stage_kind kind)
+{
+    switch (kind) {
+    case stage_kind::process_A:
+    case stage_kind::source_B: return 'A';
+    case stage_kind::process_B: return 'B';
+    default: return 0;
+    }
+}
+
+// Stages in data-flow order: depth-first from each source along the edges.
+// Consumers that produce again are visited first, so a chain stays contiguous
+// and only sinks break it
+std::vector<int> dataflow_order(const PipelineBuilder &b)
+{
+    const auto &stages = b.stages();
+    std::vector<bool> seen(stages.size(), false);
+    std::vector<int> order;
+
+    std::function<void(int)> visit = [&](int i) {
+        if (i < 0 || seen[i]) return;
+        seen[i] = true;
+        order.push_back(i);
+        for (int pass = 0; pass < 2; pass++) {
+            for (const auto &e : b.edges()) {
+                if (e.from != stages[i].name) continue;
+                int to = b.find(e.to);
+                if (to >= 0 && (output_of(stages[to].kind) != 0) == (pass == 0)) visit(to);
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < stages.size(); i++) {
+        if (!input_of(stages[i].kind)) visit((int)i);
+    }
+    for (std::size_t i = 0; i < stages.size(); i++) visit((int)i);
+    return order;
+}
+}
+
+bool PipelineBuilder::kind_from_string(const std::string &s, stage_kind &kind)
+{
+    if (s == "source_A") kind = stage_kind::source_A;
+    else if (s == "process_A") kind = stage_kind::process_A;
+    else if (s == "source_B") kind = stage_kind::source_B;
+    else if (s == "process_B") kind = stage_kind::process_B;
+    else return false;
+    return true;
+}
+
+PipelineBuilder &PipelineBuilder::stage(const std::string &name, stage_kind kind, int instances)
+{
+    stage_spec s;
+    s.name = name;
+    s.kind = kind;
+    s.instances = instances;
+    stages_.push_back(s);
+    return *this;
+}
+
+PipelineBuilder &PipelineBuilder::stage(const std::string &name, const std::string &kind, int instances)
+{
+    stage_kind k;
+    if (!kind_from_string(kind, k))
+        throw std::invalid_argument("unknown stage kind '" + kind + "' for stage '" + name + "'");
+    return stage(name, k, instances);
+}
+
+PipelineBuilder &PipelineBuilder::connect(const std::string &from, const std::string &to)
+{
+    edge_spec e;
+    e.from = from;
+    e.to = to;
+    edges_.push_back(e);
+    return *this;
+}
+
+int PipelineBuilder::find(const std::string &name) const
+{
+    for (std::size_t i = 0; i < stages_.size(); i++) {
+        if (stages_[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+void PipelineBuilder::validate(void) const
+{
+    if (stages_.empty())
+        throw std::invalid_argument("pipeline has no stages");
+
+    for (std::size_t i = 0; i < stages_.size(); i++) {
+        const stage_spec &s = stages_[i];
+        if (s.name.empty())
+            throw std::invalid_argument("stage with empty name");
+        if (find(s.name) != (int)i)
+            throw std::invalid_argument("duplicate stage '" + s.name + "'");
+        if (s.instances < 1)
+            throw std::invalid_argument("stage '" + s.name + "' needs at least one instance");
+    }
+
+    std::vector<bool> fed(stages_.size(), false);
+    for (std::size_t i = 0; i < edges_.size(); i++) {
+        const edge_spec &e = edges_[i];
+        int from = find(e.from);
+        int to = find(e.to);
+        if (from < 0) throw std::invalid_argument("edge from unknown stage '" + e.from + "'");
+        if (to < 0) throw std::invalid_argument("edge to unknown stage '" + e.to + "'");
+
+        char out = output_of(stages_[from].kind);
+        char in = input_of(stages_[to].kind);
+        if (!out) throw std::invalid_argument("stage '" + e.from + "' produces no items");
+        if (!in) throw std::invalid_argument("stage '" + e.to + "' takes no input");
+        if (out != in)
+            throw std::invalid_argument("edge " + e.from + " -> " + e.to + ": item types differ");
+
+        for (std::size_t j = 0; j < i; j++) {
+            if (edges_[j].from == e.from && edges_[j].to == e.to)
+                throw std::invalid_argument("duplicate edge " + e.from + " -> " + e.to);
+        }
+        fed[to] = true;
+    }
+
+    for (std::size_t i = 0; i < stages_.size(); i++) {
+        if (input_of(stages_[i].kind) && !fed[i])
+            throw std::invalid_argument("stage '" + stages_[i].name + "' has no input edge");
+    }
+}
+
+std::unique_ptr<Pipeline> PipelineBuilder::build(void) const
+{
+    return std::unique_ptr<Pipeline>(new Pipeline(*this));
+}
+
+std::vector<std::vector<std::vector<int>>> PipelineBuilder::placement(const cpu_topology &topo) const
+{
+    std::vector<std::vector<std::vector<int>>> cpus(stages_.size());
+    for (std::size_t i = 0; i < stages_.size(); i++)
+        cpus[i].resize(stages_[i].instances > 0 ? (std::size_t)stages_[i].instances : 0);
+    if (!cfg_) return cpus;
+
+    if (cfg_->affinity == "auto") {
+        std::vector<int> order = topo.placement_order();
+        std::size_t next = 0;
+        for (int i : dataflow_order(*this)) {
+            for (auto &instance : cpus[i]) {
+                if (!order.empty()) instance.assign(1, order[next++ % order.size()]);
+            }
+        }
+    } else if (cfg_->affinity != "none") {
+        throw std::invalid_argument("unknown affinity mode '" + cfg_->affinity + "' (none|auto)");
+    }
+
+    for (const auto &sa : cfg_->stage_affinity) {
+        int i = find(sa.first);
+        if (i < 0)
+            throw std::invalid_argument("affinity for unknown stage '" + sa.first + "'");
+        std::vector<int> set;
+        if (!parse_cpu_list(sa.second, set))
+            throw std::invalid_argument("invalid CPU list '" + sa.second + "' for stage '" + sa.first + "'");
+        for (auto &instance : cpus[i]) instance = set;
+    }
+    return cpus;
+}
+
+std::vector<wait_strategy> PipelineBuilder::wait_strategies(void) const
+{
+    if (cfg_) {
+        for (const auto &cw : cfg_->channel_waits) {
+            if (find(cw.first) < 0)
+                throw std::invalid_argument("wait strategy for unknown stage '" + cw.first + "'");
+        }
+    }
+
+    std::vector<wait_strategy> waits;
+    for (const auto &s : stages_) waits.push_back(wait_strategy_for(cfg_, s.name));
+    return waits;
+}
+
+std::vector<overflow_policy> PipelineBuilder::edge_policies(void) const
+{
+    if (cfg_) {
+        for (const auto &eb : cfg_->edge_backpressure) {
+            bool known = false;
+            for (const auto &e : edges_) known = known || edge_key(e.from, e.to) == eb.first;
+            if (!known)
+                throw std::invalid_argument("backpressure for unknown edge '" + eb.first + "'");
+        }
+    }
+
+    std::vector<overflow_policy> policies;
+    for (const auto &e : edges_) policies.push_back(overflow_policy_for(cfg_, e.from, e.to));
+    return policies;
+}
+
+PipelineBuilder PipelineBuilder::standard(BenchConfig *cfg)
+{
+    int producers = (cfg && cfg->producers > 1) ? cfg->producers : 1;
+    int consumers = (cfg && cfg->consumers > 1) ? cfg->consumers : 1;
+
+    PipelineBuilder b(cfg);
+    b.stage("sA", stage_kind::source_A)
+     .stage("pcA", stage_kind::process_A)
+     .stage("sB", stage_kind::source_B, producers)
+     .stage("pcB", stage_kind::process_B, consumers)
+     .connect("sA", "pcA")
+     .connect("sA", "sB")
+     .connect("sB", "pcB");
+    return b;
+}
+
+PipelineBuilder PipelineBuilder::from_file(const std::string &path, BenchConfig *cfg)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+        throw std::invalid_argument("cannot open pipeline file '" + path + "'");
+    return parse(in, cfg);
+}
+
+PipelineBuilder PipelineBuilder::parse(std::istream &in, BenchConfig *cfg)
+{
+    PipelineBuilder b(cfg);
+    std::string line;
+    int line_no = 0;
+
+    while (std::getline(in, line)) {
+        line_no++;
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream ss(line);
+        std::string directive;
+        if (!(ss >> directive)) continue;   // blank line
+
+        std::string a, c, extra;
+        const std::string where = "line " + std::to_string(line_no) + ": ";
+        if (directive == "stage") {
+            if (!(ss >> a >> c))
+                throw std::invalid_argument(where + "expected 'stage <name> <kind> [instances]'");
+            int instances = 1;
+            if (ss >> extra) {
+                std::istringstream n(extra);
+                if (!(n >> instances) || !n.eof())
+                    throw std::invalid_argument(where + "invalid instance count '" + extra + "'");
+                if (ss >> extra)
+                    throw std::invalid_argument(where + "unexpected '" + extra + "'");
+            }
+            stage_kind kind;
+            if (!kind_from_string(c, kind))
+                throw std::invalid_argument(where + "unknown stage kind '" + c + "'");
+            b.stage(a, kind, instances);
+        } else if (directive == "edge") {
+            if (!(ss >> a >> c))
+                throw std::invalid_argument(where + "expected 'edge <from> <to>'");
+            if (ss >> extra)
+                throw std::invalid_argument(where + "unexpected '" + extra + "'");
+            b.connect(a, c);
+        } else {
+            throw std::invalid_argument(where + "unknown directive '" + directive + "'");
+        }
+    }
+    return b;
+}
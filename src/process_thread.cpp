@@ -1,51 +1,81 @@
 #include "process_thread.h"
 #include <chrono>
+#include <iterator>
+#include <numeric>
 
 // process_A implementations
 void process_A::run(void)
 {
-    if (!cap) {
+    if (!in) {
         printf("[process_A] Capture não inicado!!\n");
         return;
     }
 
-    buffer_source_A val;
-    cap->read(&val);
+    std::size_t n;
+    {
+        profile_zone<zone_id::pcA_wait> zone;
+        n = in->read_batch(batch.data(), batch.size(), wait_timeout());
+    }
+    if (n == 0) return;
 
-    startProfile("pcA");
-    process_buffer(&val.data);
-    std::this_thread::sleep_for(std::chrono::milliseconds(250));
-    stopProfile("pcA");
+    long long t0 = latency_now_ns();
+    {
+        profile_zone<zone_id::pcA> zone;
+        for (std::size_t i = 0; i < n; i++) {
+            process_buffer(*batch[i]);
+            batch[i].reset();
+        }
+        work.run(std::chrono::milliseconds(250));
+    }
+    // A cycle cut short by stop()/pause() is not a latency sample
+    if (metrics && !get_stop_token().stop_requested()) metrics->pcA.record(latency_now_ns() - t0);
 }
 
-void process_A::process_buffer(int *buffer)
+void process_A::process_buffer(const frame_A &frame)
 {
+    checksum_ = std::accumulate(std::begin(frame.body), std::end(frame.body), checksum_);
     if (cfg && cfg->work_us > 0) {
-        std::this_thread::sleep_for(std::chrono::microseconds(cfg->work_us));
+        work.run(std::chrono::microseconds(cfg->work_us));
     }
 }
 
 // process_B implementations
 void process_B::run(void)
 {
-    if (!cap) {
+    if (!in) {
         printf("[process_B] Capture não inicado!!\n");
         return;
     }
 
-    buffer_source_B val;
-    cap->read(&val);
+    std::size_t n;
+    {
+        profile_zone<zone_id::pcB_wait> zone;
+        n = in->read_batch(batch.data(), batch.size(), wait_timeout());
+    }
+    if (n == 0) return;
+
+    long long t0 = latency_now_ns();
+    {
+        profile_zone<zone_id::pcB> zone;
+        for (std::size_t i = 0; i < n; i++) process_buffer(*batch[i]);
+        work.run(std::chrono::milliseconds(57));
+    }
 
-    startProfile("pcB");
-    process_buffer(&val.data);
-    std::this_thread::sleep_for(std::chrono::milliseconds(57));
-    stopProfile("pcB");
+    if (metrics && !get_stop_token().stop_requested()) {
+        long long done = latency_now_ns();
+        metrics->pcB.record(done - t0);
+        for (std::size_t i = 0; i < n; i++) {
+            if (batch[i]->head.origin_ns > 0) metrics->end_to_end.record(done - batch[i]->head.origin_ns);
+        }
+    }
+    for (std::size_t i = 0; i < n; i++) batch[i].reset();
 }
 
-void process_B::process_buffer(int *buffer)
+void process_B::process_buffer(const frame_B &frame)
 {
+    checksum_ = std::accumulate(std::begin(frame.body), std::end(frame.body), checksum_);
     if (cfg && cfg->work_us > 0) {
-        std::this_thread::sleep_for(std::chrono::microseconds(cfg->work_us));
+        work.run(std::chrono::microseconds(cfg->work_us));
     }
     inc_processed_items(1);
 }
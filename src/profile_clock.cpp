@@ -0,0 +1,75 @@
+#include "profile_clock.h"
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if PROFILE_CLOCK_HAS_TSC
+#include <cpuid.h>
+#endif
+
+using namespace std::chrono;
+
+std::atomic<const profile_clock::calibration *> profile_clock::tsc_{nullptr};
+
+namespace {
+// Interval over which rdtsc is measured against steady_clock
+constexpr milliseconds calibration_interval{20};
+
+long long steady_ns()
+{
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+}
+
+bool profile_clock::tsc_available()
+{
+#if PROFILE_CLOCK_HAS_TSC
+    // CPUID 0x80000007 EDX bit 8: invariant TSC (constant rate, runs in all C-states)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0x80000007, &a, &b, &c, &d)) return false;
+    return (d & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+long long profile_clock::to_ns(long long ticks)
+{
+    const calibration *c = tsc_.load(std::memory_order_acquire);
+    if (!c) return ticks;
+    return c->base_ns + (long long)((double)(ticks - c->base_ticks) * c->ns_per_tick);
+}
+
+bool profile_clock::select(profile_clock_source source)
+{
+    if (source == profile_clock_source::steady) {
+        tsc_.store(nullptr, std::memory_order_release);
+        return true;
+    }
+
+#if PROFILE_CLOCK_HAS_TSC
+    if (!tsc_available()) return false;
+
+    long long ns0 = steady_ns();
+    long long t0 = (long long)__rdtsc();
+    std::this_thread::sleep_for(calibration_interval);
+    long long ns1 = steady_ns();
+    long long t1 = (long long)__rdtsc();
+    if (t1 <= t0 || ns1 <= ns0) return false;
+
+    // Every calibration ever published is kept: to_ns() may still be reading
+    // an old one, and select() only runs a handful of times per process
+    static std::mutex kept_mtx;
+    static std::vector<std::unique_ptr<const calibration>> kept;
+    const calibration *c = new calibration{t1, ns1, (double)(ns1 - ns0) / (double)(t1 - t0)};
+    {
+        std::lock_guard<std::mutex> lk(kept_mtx);
+        kept.emplace_back(c);
+    }
+    tsc_.store(c, std::memory_order_release);
+    return true;
+#else
+    return false;
+#endif
+}
@@ -1,88 +1,556 @@
 #include "profile_print.h"
+#include "profile_clock.h"
+#include "spsc_ring.h"
 #include <chrono>
+#include <cstdio>
 
 using namespace std::chrono;
 
+// Ring filled by exactly one recording thread and drained by the writer
+struct ProfilePrinter::thread_buffer {
+    spsc_ring<profile_event> ring{profile_ring_capacity};
+    // Registration order; identifies the thread in binary traces
+    unsigned id = 0;
+    // Set when the owning thread exits; the writer drops the ring once empty
+    std::atomic<bool> retired{false};
+    // Owner thread only: zones seen (for 1-in-N sampling) and whether the
+    // open zone was admitted, so its stop follows the start's decision
+    unsigned seen[zone_count] = {};
+    bool admitted[zone_count] = {};
+
+    // Zone aggregates, written by the owner only (relaxed load + store, no
+    // read-modify-write) and read by zone_stats(). Durations in ticks
+    struct zone_accumulator {
+        std::atomic<unsigned long long> count{0};
+        std::atomic<long long> total{0};
+        std::atomic<long long> min{0};
+        std::atomic<long long> max{0};
+
+        void add(long long d)
+        {
+            unsigned long long n = count.load(std::memory_order_relaxed);
+            if (n == 0 || d < min.load(std::memory_order_relaxed)) min.store(d, std::memory_order_relaxed);
+            if (d > max.load(std::memory_order_relaxed)) max.store(d, std::memory_order_relaxed);
+            total.store(total.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+            count.store(n + 1, std::memory_order_release);
+        }
+    };
+    zone_accumulator zones[zone_count];
+    // Start of the open zone and the aggregation epoch it was opened in
+    long long opened_at[zone_count] = {};
+    unsigned opened_epoch[zone_count] = {};
+};
+
+namespace {
+// How often the background writer drains the rings
+constexpr milliseconds drain_interval{10};
+
+// Events moved out of a ring per try_pop_batch() call
+constexpr std::size_t drain_batch = 1024;
+
+struct buffer_handle {
+    std::shared_ptr<ProfilePrinter::thread_buffer> buf;
+    ~buffer_handle() { if (buf) buf->retired.store(true, std::memory_order_release); }
+};
+thread_local buffer_handle tls_buffer;
+}
+
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "trigger_capture_from_signal needs a lock-free flag");
+std::atomic<bool> ProfilePrinter::capture_signalled_{false};
+
 ProfilePrinter& ProfilePrinter::get()
 {
     static ProfilePrinter inst;
     return inst;
 }
 
-ProfilePrinter::ProfilePrinter() : muted_(false) {}
+ProfilePrinter::ProfilePrinter() : scratch_(drain_batch)
+{
+    writer_ = std::thread(&ProfilePrinter::writer_main, this);
+}
 
 ProfilePrinter::~ProfilePrinter()
 {
-    if (log_file_.is_open()) {
-        log_file_.close();
+    {
+        std::lock_guard<std::mutex> lk(writer_mtx_);
+        stopping_ = true;
     }
+    writer_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+
+    std::lock_guard<std::mutex> lk(file_mtx_);
+    close_locked();
+}
+
+profile_format ProfilePrinter::format_for(const std::string &path)
+{
+    const std::string ext = ".csv";
+    if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0)
+        return profile_format::csv;
+    return profile_format::binary;
 }
 
 bool ProfilePrinter::open_file(const std::string &path)
 {
-    std::lock_guard<std::mutex> lk(mtx_);
-    
+    return open_file(path, format_for(path));
+}
+
+bool ProfilePrinter::open_file(const std::string &path, profile_format format)
+{
+    std::lock_guard<std::mutex> lk(file_mtx_);
+
     // Close existing file if open
-    if (log_file_.is_open()) {
-        log_file_.close();
-    }
-    
+    close_locked();
+
     // Open file for appending
-    log_file_.open(path, std::ios::app);
+    format_ = format;
+    log_file_.open(path, format_ == profile_format::binary ? std::ios::app | std::ios::binary : std::ios::app);
     if (!log_file_.is_open()) {
         return false;
     }
-    
-    // Write header if file is empty
-    log_file_.seekp(0, std::ios::end);
-    if (log_file_.tellp() == 0) {
-        log_file_ << "thread,time,status\n";
+
+    if (format_ == profile_format::binary) {
+        // Every open starts a segment, so appended runs remain decodable
+        encoder_.clear();
+        encoder_.begin_segment(profile_clock::to_ns(profile_clock::now()));
+        log_file_.write(encoder_.data().data(), (std::streamsize)encoder_.data().size());
+        encoder_.clear();
         log_file_.flush();
+    } else {
+        // Write header if file is empty
+        log_file_.seekp(0, std::ios::end);
+        if (log_file_.tellp() == 0) {
+            log_file_ << "thread,time,status\n";
+            log_file_.flush();
+        }
     }
-    
+
+    has_output_.store(true, std::memory_order_release);
     return true;
 }
 
 void ProfilePrinter::set_stream(std::ofstream &&stream)
 {
-    std::lock_guard<std::mutex> lk(mtx_);
-    if (log_file_.is_open()) {
-        log_file_.close();
-    }
+    std::lock_guard<std::mutex> lk(file_mtx_);
+    close_locked();
     log_file_ = std::move(stream);
+    format_ = profile_format::csv;
+    has_output_.store(log_file_.is_open(), std::memory_order_release);
+}
+
+bool ProfilePrinter::recording() const
+{
+    return has_output_.load(std::memory_order_relaxed) && !muted_.load(std::memory_order_relaxed);
+}
+
+ProfilePrinter::thread_buffer *ProfilePrinter::local_buffer()
+{
+    if (!tls_buffer.buf) {
+        tls_buffer.buf = std::make_shared<thread_buffer>();
+        std::lock_guard<std::mutex> lk(registry_mtx_);
+        tls_buffer.buf->id = next_thread_id_++;
+        buffers_.push_back(tls_buffer.buf);
+    }
+    return tls_buffer.buf.get();
+}
+
+void ProfilePrinter::record(const profile_event &ev)
+{
+    if (!local_buffer()->ring.try_push(ev))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ProfilePrinter::write_line(const char *name, long long t, int status)
 {
-    std::lock_guard<std::mutex> lk(mtx_);
-    if (muted_ || !log_file_.is_open()) return;
-    
-    log_file_ << name << "," << t << "," << status << "\n";
-    log_file_.flush();
+    if (!recording()) return;
+
+    profile_event ev;
+    ev.name = name;
+    ev.t = t;
+    ev.status = status;
+    record(ev);
 }
 
 void ProfilePrinter::start(const char *name)
 {
-    long long t = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-    write_line(name, t, 0);
-    write_line(name, t, 1);
+    if (!recording()) return;
+
+    write_line(name, profile_clock::now(), profile_zone_begin);
 }
 
 void ProfilePrinter::stop(const char *name)
 {
-    long long t = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
-    write_line(name, t, 1);
-    write_line(name, t, 0);
+    if (!recording()) return;
+
+    write_line(name, profile_clock::now(), profile_zone_end);
+}
+
+void ProfilePrinter::start(zone_id zone)
+{
+    const bool rec = recording();
+    const bool agg = aggregating_.load(std::memory_order_relaxed);
+    if (!rec && !agg) return;
+
+    thread_buffer *buf = local_buffer();
+    const unsigned z = (unsigned)zone;
+    profile_event ev;
+    ev.zone = zone;
+    ev.t = profile_clock::now();
+    ev.status = profile_zone_begin;
+    if (agg) {
+        buf->opened_at[z] = ev.t;
+        buf->opened_epoch[z] = aggregate_epoch_.load(std::memory_order_relaxed);
+    }
+    buf->admitted[z] = rec && admit(buf, zone, ev.t);
+    if (buf->admitted[z]) record(ev);
+}
+
+void ProfilePrinter::stop(zone_id zone)
+{
+    const bool rec = recording();
+    const bool agg = aggregating_.load(std::memory_order_relaxed);
+    if (!rec && !agg) return;
+
+    thread_buffer *buf = local_buffer();
+    const unsigned z = (unsigned)zone;
+    profile_event ev;
+    ev.zone = zone;
+    ev.t = profile_clock::now();
+    ev.status = profile_zone_end;
+    if (agg && buf->opened_epoch[z] == aggregate_epoch_.load(std::memory_order_relaxed))
+        buf->zones[z].add(ev.t - buf->opened_at[z]);
+    buf->opened_epoch[z] = 0;
+
+    if (!rec || !buf->admitted[z]) return;
+    buf->admitted[z] = false;
+    record(ev);
+}
+
+bool ProfilePrinter::admit(thread_buffer *buf, zone_id zone, long long ticks)
+{
+    const unsigned every = sample_every_.load(std::memory_order_relaxed);
+    if (every > 1 && buf->seen[(unsigned)zone]++ % every != 0) {
+        sampled_out_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const long long capture = capture_ns_.load(std::memory_order_relaxed);
+    const unsigned budget = budget_per_s_.load(std::memory_order_relaxed);
+    if (capture <= 0 && budget == 0) return true;
+
+    const long long now_ns = profile_clock::to_ns(ticks);
+    if (capture > 0) {
+        if (capture_pending_.load(std::memory_order_relaxed) && capture_pending_.exchange(false))
+            capture_until_ns_.store(now_ns + capture, std::memory_order_relaxed);
+        if (now_ns >= capture_until_ns_.load(std::memory_order_relaxed)) {
+            outside_capture_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    if (budget > 0) {
+        // The first zone of a new second resets the count
+        const long long second = now_ns / 1000000000LL;
+        long long current = budget_second_.load(std::memory_order_relaxed);
+        if (second != current && budget_second_.compare_exchange_strong(current, second))
+            budget_used_.store(0, std::memory_order_relaxed);
+        if (budget_used_.fetch_add(1, std::memory_order_relaxed) >= budget) {
+            over_budget_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProfilePrinter::set_sampling(const profile_sampling &sampling)
+{
+    sample_every_.store(sampling.sample_every > 1 ? sampling.sample_every : 1, std::memory_order_relaxed);
+    capture_ns_.store(sampling.capture_ms > 0 ? sampling.capture_ms * 1000000LL : 0, std::memory_order_relaxed);
+    budget_per_s_.store(sampling.budget_per_s, std::memory_order_relaxed);
+    capture_pending_.store(false, std::memory_order_relaxed);
+    capture_until_ns_.store(0, std::memory_order_relaxed);
+    budget_second_.store(-1, std::memory_order_relaxed);
+    budget_used_.store(0, std::memory_order_relaxed);
+}
+
+profile_sampling ProfilePrinter::sampling() const
+{
+    profile_sampling s;
+    s.sample_every = sample_every_.load(std::memory_order_relaxed);
+    s.capture_ms = capture_ns_.load(std::memory_order_relaxed) / 1000000LL;
+    s.budget_per_s = budget_per_s_.load(std::memory_order_relaxed);
+    return s;
+}
+
+profile_sampling_stats ProfilePrinter::sampling_stats() const
+{
+    profile_sampling_stats s;
+    s.sampled_out = sampled_out_.load(std::memory_order_relaxed);
+    s.outside_capture = outside_capture_.load(std::memory_order_relaxed);
+    s.over_budget = over_budget_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void ProfilePrinter::zone_totals::merge(unsigned long long n, long long sum, long long lo, long long hi)
+{
+    if (n == 0) return;
+    if (count == 0 || lo < min) min = lo;
+    if (count == 0 || hi > max) max = hi;
+    threads++;
+    count += n;
+    total += sum;
+}
+
+void ProfilePrinter::set_aggregation(bool on)
+{
+    std::lock_guard<std::mutex> lk(aggregate_mtx_);
+    if (on == aggregating_.load(std::memory_order_relaxed)) return;
+
+    const long long now_ns = profile_clock::to_ns(profile_clock::now());
+    if (on) {
+        aggregate_epoch_.fetch_add(1, std::memory_order_relaxed);
+        aggregate_since_ns_ = now_ns;
+    } else {
+        aggregated_ns_ += now_ns - aggregate_since_ns_;
+    }
+    aggregating_.store(on, std::memory_order_release);
+}
+
+zone_report ProfilePrinter::zone_stats()
+{
+    zone_totals totals[zone_count];
+    {
+        std::lock_guard<std::mutex> lk(registry_mtx_);
+        for (unsigned z = 0; z < zone_count; z++) totals[z] = retired_[z];
+        for (const auto &buf : buffers_) {
+            for (unsigned z = 0; z < zone_count; z++) {
+                const thread_buffer::zone_accumulator &a = buf->zones[z];
+                unsigned long long n = a.count.load(std::memory_order_acquire);
+                totals[z].merge(n, a.total.load(std::memory_order_relaxed), a.min.load(std::memory_order_relaxed),
+                                a.max.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    zone_report r;
+    {
+        std::lock_guard<std::mutex> lk(aggregate_mtx_);
+        long long ns = aggregated_ns_;
+        if (aggregating_.load(std::memory_order_relaxed))
+            ns += profile_clock::to_ns(profile_clock::now()) - aggregate_since_ns_;
+        r.elapsed_ns = (double)ns;
+    }
+
+    // Durations are tick differences; the tick to ns mapping is affine
+    const long long zero = profile_clock::to_ns(0);
+    for (unsigned z = 0; z < zone_count; z++) {
+        if (totals[z].count == 0) continue;
+        zone_summary s;
+        s.zone = (zone_id)z;
+        s.threads = totals[z].threads;
+        s.count = totals[z].count;
+        s.total_ns = (double)(profile_clock::to_ns(totals[z].total) - zero);
+        s.min_ns = (double)(profile_clock::to_ns(totals[z].min) - zero);
+        s.max_ns = (double)(profile_clock::to_ns(totals[z].max) - zero);
+        r.zones.push_back(s);
+    }
+    return r;
+}
+
+void ProfilePrinter::reset_zone_stats()
+{
+    {
+        std::lock_guard<std::mutex> lk(registry_mtx_);
+        for (unsigned z = 0; z < zone_count; z++) retired_[z] = zone_totals();
+        for (const auto &buf : buffers_) {
+            for (unsigned z = 0; z < zone_count; z++) {
+                thread_buffer::zone_accumulator &a = buf->zones[z];
+                a.count.store(0, std::memory_order_relaxed);
+                a.total.store(0, std::memory_order_relaxed);
+                a.min.store(0, std::memory_order_relaxed);
+                a.max.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(aggregate_mtx_);
+    aggregated_ns_ = 0;
+    if (aggregating_.load(std::memory_order_relaxed))
+        aggregate_since_ns_ = profile_clock::to_ns(profile_clock::now());
+}
+
+void ProfilePrinter::fold_retired(const thread_buffer &buf)
+{
+    for (unsigned z = 0; z < zone_count; z++) {
+        const thread_buffer::zone_accumulator &a = buf.zones[z];
+        retired_[z].merge(a.count.load(std::memory_order_acquire), a.total.load(std::memory_order_relaxed),
+                          a.min.load(std::memory_order_relaxed), a.max.load(std::memory_order_relaxed));
+    }
+}
+
+void write_zone_report(std::ostream &out, const zone_report &report)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "# profile zones over %.3f s\n", report.elapsed_ns / 1e9);
+    out << line;
+    if (report.zones.empty()) {
+        out << (profile_level == profile_level_off ? "# no zones: all compiled out (PROFILE_LEVEL=0)\n"
+                                                   : "# no zones recorded\n");
+        return;
+    }
+    // Share of the elapsed time, per thread that recorded the zone
+    auto util = [&report](const zone_summary *s) {
+        return s && s->threads && report.elapsed_ns > 0 ? 100.0 * s->total_ns / (report.elapsed_ns * s->threads)
+                                                        : 0.0;
+    };
+    const zone_summary *by_zone[zone_count] = {};
+    for (const zone_summary &s : report.zones) by_zone[(unsigned)s.zone] = &s;
+
+    std::snprintf(line, sizeof(line), "%-10s %-4s %7s %10s %12s %8s %12s %12s %12s\n", "zone", "kind", "threads",
+                  "count", "total_ms", "util_%", "min_us", "mean_us", "max_us");
+    out << line;
+    for (const zone_summary &s : report.zones) {
+        std::snprintf(line, sizeof(line), "%-10s %-4s %7u %10llu %12.3f %8.1f %12.1f %12.1f %12.1f\n",
+                      zone_name(s.zone), zone_waits(s.zone) ? "wait" : "work", s.threads, s.count, s.total_ns / 1e6,
+                      util(&s), s.min_ns / 1e3, s.mean_ns() / 1e3, s.max_ns / 1e3);
+        out << line;
+    }
+
+    // Stage-level zones only: detail zones nest inside them or sit beside them
+    const zone_summary *bottleneck = nullptr;
+    bool header = false;
+    for (const zone_summary &s : report.zones) {
+        if (zone_level(s.zone) != profile_level_stage) continue;
+        if (!header) {
+            std::snprintf(line, sizeof(line), "# %-8s %7s %8s %8s %s\n", "stage", "threads", "busy_%", "wait_%",
+                          "wait_zone");
+            out << line;
+            header = true;
+        }
+        zone_id w = zone_wait_of(s.zone);
+        const zone_summary *wait = w == zone_id::count ? nullptr : by_zone[(unsigned)w];
+        std::snprintf(line, sizeof(line), "# %-8s %7u %8.1f %8.1f %s\n", zone_name(s.zone), s.threads, util(&s),
+                      util(wait), w == zone_id::count ? "-" : zone_name(w));
+        out << line;
+        if (!bottleneck || util(&s) > util(bottleneck)) bottleneck = &s;
+    }
+
+    if (bottleneck) {
+        std::snprintf(line, sizeof(line), "# bottleneck: %s (%.1f%% busy per thread, %u threads)\n",
+                      zone_name(bottleneck->zone), util(bottleneck), bottleneck->threads);
+        out << line;
+    }
+}
+
+bool ProfilePrinter::set_clock(profile_clock_source source)
+{
+    // Pending ticks must be converted with the calibration they were taken with
+    std::lock_guard<std::mutex> lk(file_mtx_);
+    drain_locked();
+    return profile_clock::select(source);
+}
+
+void ProfilePrinter::flush()
+{
+    std::lock_guard<std::mutex> lk(file_mtx_);
+    drain_locked();
+}
+
+void ProfilePrinter::drain_locked()
+{
+    std::vector<std::shared_ptr<thread_buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lk(registry_mtx_);
+        buffers = buffers_;
+    }
+
+    bool wrote = false;
+    std::vector<thread_buffer*> finished;
+    for (auto &buf : buffers) {
+        // Read before draining: a retired ring receives no more events
+        bool retired = buf->retired.load(std::memory_order_acquire);
+
+        std::size_t n;
+        while ((n = buf->ring.try_pop_batch(scratch_.data(), scratch_.size())) > 0) {
+            if (!log_file_.is_open()) continue;   // no output: discard
+            for (std::size_t i = 0; i < n; i++) {
+                if (scratch_[i].status == profile_zone_begin || scratch_[i].status == profile_zone_end)
+                    scratch_[i].t = profile_clock::to_ns(scratch_[i].t);
+                if (!scratch_[i].name) scratch_[i].name = zone_name(scratch_[i].zone);
+            }
+            write_events(buf->id, scratch_.data(), n);
+            wrote = true;
+        }
+
+        if (retired) finished.push_back(buf.get());
+    }
+
+    if (wrote) {
+        if (format_ == profile_format::binary) {
+            log_file_.write(encoder_.data().data(), (std::streamsize)encoder_.data().size());
+            encoder_.clear();
+        }
+        log_file_.flush();
+    }
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lk(registry_mtx_);
+        for (thread_buffer *done : finished) {
+            for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+                if (it->get() == done) { fold_retired(*done); buffers_.erase(it); break; }
+            }
+        }
+    }
+}
+
+void ProfilePrinter::write_events(unsigned thread, const profile_event *events, std::size_t count)
+{
+    if (format_ == profile_format::binary) {
+        for (std::size_t i = 0; i < count; i++)
+            encoder_.event(thread, events[i].name, events[i].t, events[i].status);
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        const profile_event &ev = events[i];
+        if (ev.status == profile_zone_begin) {
+            log_file_ << ev.name << "," << ev.t << ",0\n" << ev.name << "," << ev.t << ",1\n";
+        } else if (ev.status == profile_zone_end) {
+            log_file_ << ev.name << "," << ev.t << ",1\n" << ev.name << "," << ev.t << ",0\n";
+        } else {
+            log_file_ << ev.name << "," << ev.t << "," << ev.status << "\n";
+        }
+    }
+}
+
+void ProfilePrinter::close_locked()
+{
+    drain_locked();
+    has_output_.store(false, std::memory_order_release);
+    if (log_file_.is_open()) {
+        log_file_.close();
+    }
+}
+
+void ProfilePrinter::writer_main()
+{
+    std::unique_lock<std::mutex> lk(writer_mtx_);
+    while (!stopping_) {
+        writer_cv_.wait_for(lk, drain_interval, [this] { return stopping_; });
+        lk.unlock();
+        if (capture_signalled_.load(std::memory_order_relaxed) && capture_signalled_.exchange(false))
+            trigger_capture();
+        flush();
+        lk.lock();
+    }
 }
 
 void ProfilePrinter::mute()
 {
-    std::lock_guard<std::mutex> lk(mtx_);
-    muted_ = true;
+    muted_.store(true, std::memory_order_relaxed);
 }
 
 void ProfilePrinter::unmute()
 {
-    std::lock_guard<std::mutex> lk(mtx_);
-    muted_ = false;
+    muted_.store(false, std::memory_order_relaxed);
 }
@@ -0,0 +1,263 @@
+#include "profile_trace.h"
+#include "profile_print.h"
+#include <cstdio>
+#include <istream>
+#include <ostream>
+
+namespace {
+enum : unsigned char {
+    tag_name = 0x01,
+    tag_thread = 0x02,
+    tag_event = 0x04,
+    tag_status_event = 0x10   // + status (0..3)
+};
+
+unsigned long long zigzag(long long v)
+{
+    return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63);
+}
+
+long long unzigzag(unsigned long long v)
+{
+    return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+// Microseconds with three decimals, as expected by the "ts" field
+void put_us(std::ostream &out, long long ns)
+{
+    char buf[32];
+    const char *sign = ns < 0 ? "-" : "";
+    unsigned long long a = ns < 0 ? 0ULL - (unsigned long long)ns : (unsigned long long)ns;
+    std::snprintf(buf, sizeof(buf), "%s%llu.%03llu", sign, a / 1000, a % 1000);
+    out << buf;
+}
+
+void put_json_string(std::ostream &out, const std::string &s)
+{
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+            out << buf;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+}
+
+// ---------------------------------------------------------------- encoder
+
+void trace_encoder::begin_segment(long long base_t)
+{
+    buf_.append((const char*)profile_trace_magic, sizeof(profile_trace_magic));
+    buf_.push_back((char)profile_trace_version);
+    put_signed(base_t);
+
+    names_.clear();
+    has_thread_ = false;
+    prev_t_ = base_t;
+}
+
+void trace_encoder::event(unsigned thread, const char *name, long long t, int status)
+{
+    unsigned id = intern(name);
+
+    if (!has_thread_ || thread != thread_) {
+        buf_.push_back((char)tag_thread);
+        put_varint(thread);
+        thread_ = thread;
+        has_thread_ = true;
+    }
+
+    if (status >= 0 && status <= 3) {
+        buf_.push_back((char)(tag_status_event + status));
+        put_varint(id);
+        put_signed(t - prev_t_);
+    } else {
+        buf_.push_back((char)tag_event);
+        put_varint(id);
+        put_signed(t - prev_t_);
+        put_signed(status);
+    }
+    prev_t_ = t;
+}
+
+unsigned trace_encoder::intern(const char *name)
+{
+    auto it = names_.find(name);
+    if (it != names_.end()) return it->second;
+
+    unsigned id = (unsigned)names_.size();
+    std::string s(name);
+    buf_.push_back((char)tag_name);
+    put_varint(id);
+    put_varint(s.size());
+    buf_.append(s);
+    names_.emplace(std::move(s), id);
+    return id;
+}
+
+void trace_encoder::put_varint(unsigned long long v)
+{
+    while (v >= 0x80) {
+        buf_.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    buf_.push_back((char)v);
+}
+
+void trace_encoder::put_signed(long long v)
+{
+    put_varint(zigzag(v));
+}
+
+// ---------------------------------------------------------------- decoder
+
+bool trace_decoder::fail()
+{
+    failed_ = true;
+    return false;
+}
+
+bool trace_decoder::get_varint(unsigned long long &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int c = in_.get();
+        if (c == EOF) return fail();
+        v |= (unsigned long long)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return fail();
+}
+
+bool trace_decoder::get_signed(long long &v)
+{
+    unsigned long long u;
+    if (!get_varint(u)) return false;
+    v = unzigzag(u);
+    return true;
+}
+
+bool trace_decoder::read_header()
+{
+    unsigned char h[sizeof(profile_trace_magic) + 1];
+    if (!in_.read((char*)h, sizeof(h))) return fail();
+    for (std::size_t i = 0; i < sizeof(profile_trace_magic); i++) {
+        if (h[i] != profile_trace_magic[i]) return fail();
+    }
+    if (h[sizeof(profile_trace_magic)] != profile_trace_version) return fail();
+    if (!get_signed(base_t_)) return false;
+
+    segment_++;
+    names_.clear();
+    thread_ = 0;
+    prev_t_ = base_t_;
+    return true;
+}
+
+bool trace_decoder::next(trace_record &rec)
+{
+    if (failed_) return false;
+
+    for (;;) {
+        int c = in_.peek();
+        if (c == EOF) return false;
+
+        if (c == profile_trace_magic[0]) {
+            if (!read_header()) return false;
+            continue;
+        }
+        if (segment_ == 0) return fail();   // not a trace
+
+        in_.get();
+        unsigned long long id, len;
+        long long dt, status;
+        switch (c) {
+        case tag_name:
+            if (!get_varint(id) || !get_varint(len)) return false;
+            if (id != names_.size()) return fail();
+            names_.emplace_back(len, '\0');
+            if (len > 0 && !in_.read(&names_.back()[0], (std::streamsize)len)) return fail();
+            break;
+
+        case tag_thread:
+            if (!get_varint(id)) return false;
+            thread_ = (unsigned)id;
+            break;
+
+        default:
+            if (c != tag_event && (c < tag_status_event || c > tag_status_event + 3)) return fail();
+            if (!get_varint(id) || !get_signed(dt)) return false;
+            if (c == tag_event) {
+                if (!get_signed(status)) return false;
+            } else {
+                status = c - tag_status_event;
+            }
+            if (id >= names_.size()) return fail();
+
+            prev_t_ += dt;
+            rec.segment = segment_;
+            rec.base_t = base_t_;
+            rec.thread = thread_;
+            rec.name = &names_[id];
+            rec.t = prev_t_;
+            rec.status = (int)status;
+            return true;
+        }
+    }
+}
+
+// ---------------------------------------------------------------- converters
+
+bool trace_to_csv(std::istream &in, std::ostream &out)
+{
+    trace_decoder dec(in);
+    trace_record r;
+
+    out << "thread,time,status\n";
+    while (dec.next(r)) {
+        const std::string &n = *r.name;
+        if (r.status == profile_zone_begin) {
+            out << n << "," << r.t << ",0\n" << n << "," << r.t << ",1\n";
+        } else if (r.status == profile_zone_end) {
+            out << n << "," << r.t << ",1\n" << n << "," << r.t << ",0\n";
+        } else {
+            out << n << "," << r.t << "," << r.status << "\n";
+        }
+    }
+    return !dec.failed();
+}
+
+bool trace_to_chrome(std::istream &in, std::ostream &out)
+{
+    trace_decoder dec(in);
+    trace_record r;
+    bool first = true;
+    long long t0 = 0;
+
+    out << "{\"traceEvents\":[";
+    while (dec.next(r)) {
+        if (first) t0 = r.base_t;
+        out << (first ? "\n" : ",\n");
+        first = false;
+
+        out << "{\"name\":";
+        put_json_string(out, *r.name);
+        if (r.status == profile_zone_begin || r.status == profile_zone_end) {
+            out << ",\"ph\":\"" << (r.status == profile_zone_begin ? 'B' : 'E') << "\"";
+        } else {
+            out << ",\"ph\":\"C\",\"args\":{\"status\":" << r.status << "}";
+        }
+        out << ",\"ts\":";
+        put_us(out, r.t - t0);
+        out << ",\"pid\":" << r.segment << ",\"tid\":" << r.thread << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return !dec.failed();
+}
@@ -0,0 +1,62 @@
+#include "run_window.h"
+#include <thread>
+
+run_window run_window::from_config(const BenchConfig *cfg)
+{
+    run_window w;
+    if (!cfg) return w;
+
+    if (cfg->duration_ms > 0)
+        w.measure = std::chrono::milliseconds(cfg->duration_ms);
+    else
+        w.measure = std::chrono::seconds(cfg->duration_s > 0 ? cfg->duration_s : 0);
+    w.warm_in = std::chrono::milliseconds(cfg->warm_in_ms > 0 ? cfg->warm_in_ms : 0);
+    w.interval = std::chrono::milliseconds(cfg->interval_ms > 0 ? cfg->interval_ms : 0);
+    return w;
+}
+
+window_result run_window::run(const std::function<long long()> &counter, const std::function<void()> &at_open,
+                              const std::function<void(const interval_sample &)> &on_interval) const
+{
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double> seconds_d;
+
+    std::this_thread::sleep_until(clock::now() + warm_in);
+
+    window_result r;
+    const clock::time_point open = clock::now();
+    const clock::time_point close = open + std::chrono::duration_cast<clock::duration>(measure);
+    const long long first = counter();
+    if (at_open) at_open();
+
+    const bool sampled = interval.count() > 0 && interval < measure;
+    const clock::duration step = std::chrono::duration_cast<clock::duration>(sampled ? interval : measure);
+    clock::time_point from = open;
+    long long from_count = first;
+    for (int i = 1; ; i++) {
+        clock::time_point deadline = open + step * i;
+        if (deadline > close) deadline = close;
+        std::this_thread::sleep_until(deadline);
+
+        const clock::time_point now = clock::now();
+        const long long count = counter();
+        if (sampled) {
+            interval_sample s;
+            s.index = i;
+            s.end_s = seconds_d(now - open).count();
+            s.processed = count - from_count;
+            s.elapsed_s = seconds_d(now - from).count();
+            s.items_per_s = s.elapsed_s > 0 ? s.processed / s.elapsed_s : 0.0;
+            r.intervals.push_back(s);
+            if (on_interval) on_interval(s);
+        }
+        from = now;
+        from_count = count;
+        if (deadline >= close) break;
+    }
+
+    r.processed = from_count - first;
+    r.elapsed_s = seconds_d(from - open).count();
+    r.items_per_s = r.elapsed_s > 0 ? r.processed / r.elapsed_s : 0.0;
+    return r;
+}
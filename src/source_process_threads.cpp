@@ -1,41 +1,111 @@
 #include "source_process_threads.h"
 #include <chrono>
+#include <cstring>
 
 void source_B::run(void)
 {
-    if (!cap) {
+    if (!in) {
         printf("[source_B] Capture não inicado!!\n");
         return;
     }
 
-    buffer_source_A val;
-    cap->read(&val);
+    std::size_t n;
+    {
+        profile_zone<zone_id::sB_wait> zone;
+        n = in->read_batch(in_batch.data(), in_batch.size(), wait_timeout());
+    }
+    if (n == 0) return;
+
+    long long t0 = latency_now_ns();
+    {
+        profile_zone<zone_id::sB> zone;
+        for (std::size_t i = 0; i < n; i++) {
+            out_batch[i] = frames_->acquire();
+            process_buffer(*in_batch[i], *out_batch[i]);
+            in_batch[i].reset();   // source_A's frame goes back once every reader is done
+        }
+        work.run(std::chrono::milliseconds(10));
 
-    startProfile("sB");
-    process_buffer(&val.data);
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    stopProfile("sB");
+        latest_.publish(out_batch[n - 1]->head);
+
+        {
+            profile_zone<zone_id::sB_prep> prep;
+            work.run(std::chrono::milliseconds(2));
+        }
+
+        publish_batch(out_batch.data(), n);
+        for (std::size_t i = 0; i < n; i++) out_batch[i].reset();
+
+        work.run(std::chrono::milliseconds(10));
+    }
+    if (metrics && !get_stop_token().stop_requested()) metrics->sB.record(latency_now_ns() - t0);
+}
+
+void source_B::process_buffer(const frame_A &in, frame_B &out)
+{
+    out.head.data = in.head.data + 1000;
+    out.head.seq = ++seq_;
+    out.head.origin_ns = in.head.origin_ns;
+    std::memset(out.body, out.head.data & 0xff, sizeof(out.body));
+}
+
+void source_B::read(buffer_source_B *dado)
+{
+    profile_zone<zone_id::sB_read> zone;
+    // Wait for data (condition is: something was published, or nothing will be)
+    buffer_source_B v = latest_.read();
+    while (v.seq == 0 && isActive())
+        latest_.wait_for(v, [](const buffer_source_B &b) { return b.seq != 0; }, stage_wait_timeout);
+    *dado = v;
 }
 
-void source_B::process_buffer(int *value)
+long long source_B::read_since(unsigned long long last_seq, buffer_source_B *dado)
 {
-    int temp_value = *value + 1000;
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bool fresh;
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        startProfile("sB_mtx");
-        buffer.data = temp_value;
-        cv_.notify_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
-        stopProfile("sB_mtx");
+        profile_zone<zone_id::sB_read> zone;
+        fresh = latest_.wait_for(*dado, [&](const buffer_source_B &b) { return b.seq > last_seq; }, stage_wait_timeout);
     }
+
+    return fresh ? (long long)(dado->seq - last_seq - 1) : -1;
 }
 
-void source_B::read(buffer_source_B *dado)
+void source_B::reset_state(void)
+{
+    seq_ = 0;
+    for (auto &item : in_batch) item.reset();
+    for (auto &item : out_batch) item.reset();
+    latest_.publish(buffer_source_B());
+
+    item_B stale;
+    for (auto &q : owned_) {
+        while (q->try_pop(stale)) stale.reset();
+    }
+}
+
+channel<item_B> *source_B::subscribe(void)
 {
-    std::unique_lock<std::mutex> lk(mtx);
-    startProfile("sB_read");
-    cv_.wait(lk, [this] { return true; });
-    *dado = buffer;
-    stopProfile("sB_read");
+    // Only a multi-consumer queue lets the producer evict the oldest item
+    overflow_policy policy = overflow_policy_for(cfg, "sB", "");
+    if (policy == overflow_policy::drop_oldest)
+        owned_.emplace_back(new mpmc_queue<item_B>(queue_capacity_of(cfg)));
+    else
+        owned_.emplace_back(new spsc_ring<item_B>(queue_capacity_of(cfg)));
+    owned_.back()->set_wait_strategy(wait_strategy_for(cfg, ""));
+    owned_.back()->set_sample_every(sample_every_of(cfg));
+    attach(owned_.back().get(), policy);
+    return owned_.back().get();
+}
+
+void source_B::attach(channel<item_B> *out, overflow_policy policy)
+{
+    outputs_.push_back(out);
+    policies_.push_back(policy);
+}
+
+void source_B::publish_batch(const item_B *items, std::size_t count)
+{
+    for (std::size_t i = 0; i < outputs_.size(); i++) {
+        if (outputs_[i]->publish_batch(items, count, *this, policies_[i]) < count) return;
+    }
 }
@@ -1,41 +1,97 @@
 #include "source_threads.h"
 #include <chrono>
+#include <cstring>
 
 void source_A::run(void)
 {
-    int temp_buffer = 0;
+    // The value is prepared in producer-private state; readers never wait on this work
+    buffer_source_A item = next_;
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        startProfile("sA_mtx");
-        temp_buffer = buffer.data + 5;
-        std::this_thread::sleep_for(std::chrono::milliseconds(3));
-        stopProfile("sA_mtx");
+        profile_zone<zone_id::sA_prep> zone;
+        item.data += 5;
+        work.run(std::chrono::milliseconds(3));
     }
 
-    startProfile("sA");
-    std::this_thread::sleep_for(std::chrono::milliseconds(45));
-    stopProfile("sA");
+    long long t0 = latency_now_ns();
+    {
+        profile_zone<zone_id::sA> zone;
+        work.run(std::chrono::milliseconds(45));
+    }
+    if (metrics && !get_stop_token().stop_requested()) metrics->sA.record(latency_now_ns() - t0);
 
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        startProfile("sA_mtx");
-        buffer.data = temp_buffer;
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-        stopProfile("sA_mtx");
+        profile_zone<zone_id::sA_prep> zone;
+        item.seq++;
+        work.run(std::chrono::milliseconds(5));
     }
-    
-    // Notify all waiting readers that new data is available
-    cv_.notify_all();
+    next_ = item;
+
+    // One seqlock store; waiting readers are woken only if there are any
+    item_A frame = frames_->acquire();
+    std::memset(frame->body, item.data & 0xff, sizeof(frame->body));
+
+    item.origin_ns = latency_now_ns();
+    frame->head = item;
+    latest_.publish(item);
+
+    publish_batch(&frame, 1);
 }
 
 void source_A::read(buffer_source_A *dado)
 {
-    std::unique_lock<std::mutex> lk(mtx);
-    startProfile("sA_read");
-    
-    // Wait for new data (condition is: we have data)
-    cv_.wait(lk, [this] { return true; });  // Waits for notification from run()
-    
-    *dado = buffer;
-    stopProfile("sA_read");
+    profile_zone<zone_id::sA_read> zone;
+    // Wait for data (condition is: something was published, or nothing will be)
+    buffer_source_A v = latest_.read();
+    while (v.seq == 0 && isActive())
+        latest_.wait_for(v, [](const buffer_source_A &b) { return b.seq != 0; }, stage_wait_timeout);
+    *dado = v;
+}
+
+long long source_A::read_since(unsigned long long last_seq, buffer_source_A *dado)
+{
+    bool fresh;
+    {
+        profile_zone<zone_id::sA_read> zone;
+        fresh = latest_.wait_for(*dado, [&](const buffer_source_A &b) { return b.seq > last_seq; }, stage_wait_timeout);
+    }
+
+    return fresh ? (long long)(dado->seq - last_seq - 1) : -1;
+}
+
+void source_A::reset_state(void)
+{
+    next_ = buffer_source_A();
+    latest_.publish(next_);
+
+    item_A stale;
+    for (auto &q : owned_) {
+        while (q->try_pop(stale)) stale.reset();
+    }
+}
+
+channel<item_A> *source_A::subscribe(void)
+{
+    // Only a multi-consumer queue lets the producer evict the oldest item
+    overflow_policy policy = overflow_policy_for(cfg, "sA", "");
+    if (policy == overflow_policy::drop_oldest)
+        owned_.emplace_back(new mpmc_queue<item_A>(queue_capacity_of(cfg)));
+    else
+        owned_.emplace_back(new spsc_ring<item_A>(queue_capacity_of(cfg)));
+    owned_.back()->set_wait_strategy(wait_strategy_for(cfg, ""));
+    owned_.back()->set_sample_every(sample_every_of(cfg));
+    attach(owned_.back().get(), policy);
+    return owned_.back().get();
+}
+
+void source_A::attach(channel<item_A> *out, overflow_policy policy)
+{
+    outputs_.push_back(out);
+    policies_.push_back(policy);
+}
+
+void source_A::publish_batch(const item_A *items, std::size_t count)
+{
+    for (std::size_t i = 0; i < outputs_.size(); i++) {
+        if (outputs_[i]->publish_batch(items, count, *this, policies_[i]) < count) return;
+    }
 }
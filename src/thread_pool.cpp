@@ -0,0 +1,150 @@
+#include "thread_pool.h"
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+namespace {
+// Pool and worker index of the calling thread (nullptr outside a worker)
+thread_local thread_pool *tls_pool = nullptr;
+thread_local std::size_t tls_index = 0;
+
+// Upper bound for a parked worker before it rechecks stopping_
+constexpr std::chrono::milliseconds park_timeout{10};
+}
+
+thread_pool::thread_pool(std::size_t workers)
+{
+    if (workers == 0) workers = std::thread::hardware_concurrency();
+    if (workers == 0) workers = 1;
+
+    for (std::size_t i = 0; i < workers; i++)
+        workers_.emplace_back(new worker());
+
+    for (std::size_t i = 0; i < workers; i++)
+        threads_.emplace_back(&thread_pool::worker_main, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+    stopping_.store(true, std::memory_order_release);
+    work_ready_.notify_all();
+    for (auto &t : threads_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+thread_pool *thread_pool::current(void)
+{
+    return tls_pool;
+}
+
+void thread_pool::submit(task t)
+{
+    if (tls_pool == this) {
+        worker &w = *workers_[tls_index];
+        std::lock_guard<std::mutex> lk(w.mtx);
+        w.tasks.push_back(std::move(t));
+    } else {
+        std::lock_guard<std::mutex> lk(global_mtx_);
+        global_.push_back(std::move(t));
+        global_size_.store(global_.size(), std::memory_order_release);
+    }
+    work_ready_.notify_one();
+}
+
+void thread_pool::reschedule(task t)
+{
+    if (tls_pool != this) {
+        submit(std::move(t));
+        return;
+    }
+
+    {
+        worker &w = *workers_[tls_index];
+        std::lock_guard<std::mutex> lk(w.mtx);
+        w.tasks.push_front(std::move(t));
+    }
+    work_ready_.notify_one();
+}
+
+bool thread_pool::pop_local(std::size_t index, task &t)
+{
+    worker &w = *workers_[index];
+    std::lock_guard<std::mutex> lk(w.mtx);
+    if (w.tasks.empty()) return false;
+    t = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool thread_pool::pop_global(task &t)
+{
+    std::lock_guard<std::mutex> lk(global_mtx_);
+    if (global_.empty()) return false;
+    t = std::move(global_.front());
+    global_.pop_front();
+    global_size_.store(global_.size(), std::memory_order_release);
+    return true;
+}
+
+bool thread_pool::steal(std::size_t thief, task &t)
+{
+    const std::size_t n = workers_.size();
+    for (std::size_t k = 1; k < n; k++) {
+        worker &victim = *workers_[(thief + k) % n];
+        std::unique_lock<std::mutex> lk(victim.mtx, std::try_to_lock);
+        if (!lk.owns_lock() || victim.tasks.empty()) continue;
+        t = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool thread_pool::take(std::size_t index, task &t)
+{
+    // Injected tasks first: rescheduled local tasks would keep them waiting forever
+    return (global_size_.load(std::memory_order_acquire) > 0 && pop_global(t)) || pop_local(index, t) ||
+           steal(index, t);
+}
+
+void thread_pool::execute(task &t)
+{
+    try {
+        t();
+    } catch (const std::exception &e) {
+        std::cerr << "[thread_pool] Exceção capturada: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[thread_pool] Exceção desconhecida capturada" << std::endl;
+    }
+}
+
+bool thread_pool::run_pending(void)
+{
+    if (tls_pool != this || stopping_.load(std::memory_order_acquire)) return false;
+    task t;
+    if (!take(tls_index, t)) return false;
+    execute(t);
+    return true;
+}
+
+void thread_pool::worker_main(std::size_t index)
+{
+    tls_pool = this;
+    tls_index = index;
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+        unsigned key = work_ready_.prepare_wait();
+
+        task t;
+        if (take(index, t)) {
+            execute(t);
+            continue;
+        }
+
+        work_ready_.wait_for(key, park_timeout);
+    }
+
+    tls_pool = nullptr;
+}
@@ -0,0 +1,39 @@
+#include "wait_strategy.h"
+#include <stdexcept>
+
+bool wait_strategy_from_string(const std::string &s, wait_strategy &strategy)
+{
+    if (s == "spin") strategy = wait_strategy::spin;
+    else if (s == "pause") strategy = wait_strategy::pause;
+    else if (s == "yield") strategy = wait_strategy::yield;
+    else if (s == "park") strategy = wait_strategy::park;
+    else if (s == "adaptive") strategy = wait_strategy::adaptive;
+    else return false;
+    return true;
+}
+
+const char *wait_strategy_name(wait_strategy strategy)
+{
+    switch (strategy) {
+    case wait_strategy::spin: return "spin";
+    case wait_strategy::pause: return "pause";
+    case wait_strategy::yield: return "yield";
+    case wait_strategy::park: return "park";
+    case wait_strategy::adaptive: return "adaptive";
+    }
+    return "?";
+}
+
+wait_strategy wait_strategy_for(const BenchConfig *cfg, const std::string &stage)
+{
+    if (!cfg) return wait_strategy::adaptive;
+
+    std::string name = cfg->wait_strategy;
+    auto it = cfg->channel_waits.find(stage);
+    if (it != cfg->channel_waits.end()) name = it->second;
+
+    wait_strategy strategy;
+    if (!wait_strategy_from_string(name, strategy))
+        throw std::invalid_argument("unknown wait strategy '" + name + "' for stage " + stage);
+    return strategy;
+}
@@ -0,0 +1,225 @@
+#include "workload.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace std::chrono;
+
+namespace {
+// Calibration runs the kernel until it takes at least this long
+constexpr nanoseconds calibration_time = milliseconds(2);
+// Timed runs of that size; the fastest one is kept
+constexpr int calibration_samples = 5;
+
+// Words hashed per hash iteration (one cache line) and size of the hash block
+constexpr std::size_t line_words = 8;
+constexpr std::size_t hash_block_words = 512;
+
+// CPU kernels with a stop token look at it after each slice of this much work
+constexpr nanoseconds stop_check_slice = milliseconds(1);
+
+// ns per iteration, per (kind, working set); measured once per process
+std::mutex calibration_mtx;
+std::map<std::pair<int, std::size_t>, double> calibration;
+}
+
+workload::workload(workload_kind kind, std::size_t working_set_bytes)
+    : kind_(kind), bytes_(working_set_bytes ? working_set_bytes : default_workload_bytes)
+{
+    prepare();
+    calibrate();
+}
+
+bool workload::kind_from_string(const std::string &s, workload_kind &kind)
+{
+    if (s == "sleep") kind = workload_kind::sleep;
+    else if (s == "spin") kind = workload_kind::spin;
+    else if (s == "hash") kind = workload_kind::hash;
+    else if (s == "memory") kind = workload_kind::memory;
+    else if (s == "pointer_chase") kind = workload_kind::pointer_chase;
+    else return false;
+    return true;
+}
+
+const char *workload::kind_name(workload_kind kind)
+{
+    switch (kind) {
+    case workload_kind::sleep: return "sleep";
+    case workload_kind::spin: return "spin";
+    case workload_kind::hash: return "hash";
+    case workload_kind::memory: return "memory";
+    case workload_kind::pointer_chase: return "pointer_chase";
+    }
+    return "?";
+}
+
+workload workload::for_stage(const BenchConfig *cfg, const std::string &stage)
+{
+    if (!cfg) return workload();
+
+    std::string name = cfg->workload;
+    auto it = cfg->stage_workloads.find(stage);
+    if (it != cfg->stage_workloads.end()) name = it->second;
+
+    workload_kind kind;
+    if (!kind_from_string(name, kind))
+        throw std::invalid_argument("unknown workload '" + name + "' for stage " + stage);
+    return workload(kind, cfg->workload_bytes);
+}
+
+void workload::prepare(void)
+{
+    switch (kind_) {
+    case workload_kind::hash:
+        data_.resize(hash_block_words);
+        for (std::size_t i = 0; i < data_.size(); i++) data_[i] = i * 0x9e3779b97f4a7c15ULL;
+        break;
+
+    case workload_kind::memory: {
+        std::size_t words = bytes_ / sizeof(std::uint64_t);
+        words -= words % line_words;
+        data_.assign(words < line_words ? line_words : words, 1);
+        break;
+    }
+
+    case workload_kind::pointer_chase: {
+        // One node per cache line, linked in a single random cycle (Sattolo)
+        std::size_t nodes = bytes_ / (line_words * sizeof(std::uint64_t));
+        if (nodes < 2) nodes = 2;
+        std::vector<std::size_t> next(nodes);
+        for (std::size_t i = 0; i < nodes; i++) next[i] = i;
+        std::mt19937_64 rng(nodes);
+        for (std::size_t i = nodes - 1; i > 0; i--) {
+            std::size_t j = (std::size_t)(rng() % i);
+            std::swap(next[i], next[j]);
+        }
+        data_.assign(nodes * line_words, 0);
+        for (std::size_t i = 0; i < nodes; i++) data_[i * line_words] = next[i] * line_words;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void workload::calibrate(void)
+{
+    if (kind_ == workload_kind::sleep) return;
+
+    std::pair<int, std::size_t> key((int)kind_, kind_ == workload_kind::spin ? 0 : bytes_);
+    {
+        std::lock_guard<std::mutex> lk(calibration_mtx);
+        auto it = calibration.find(key);
+        if (it != calibration.end()) {
+            ns_per_iter_ = it->second;
+            return;
+        }
+    }
+
+    // Warm the working set, then time growing batches
+    step(data_.size() / line_words + 1);
+    std::uint64_t iters = 1024;
+    for (;;) {
+        auto t0 = steady_clock::now();
+        step(iters);
+        nanoseconds elapsed = duration_cast<nanoseconds>(steady_clock::now() - t0);
+        if (elapsed >= calibration_time) {
+            ns_per_iter_ = (double)elapsed.count() / (double)iters;
+            break;
+        }
+        iters *= 2;
+    }
+
+    // A preemption inside a sample only makes it slower: keep the fastest
+    for (int i = 1; i < calibration_samples; i++) {
+        auto t0 = steady_clock::now();
+        step(iters);
+        double ns = (double)duration_cast<nanoseconds>(steady_clock::now() - t0).count() / (double)iters;
+        if (ns < ns_per_iter_) ns_per_iter_ = ns;
+    }
+
+    std::lock_guard<std::mutex> lk(calibration_mtx);
+    calibration.emplace(key, ns_per_iter_);
+}
+
+std::uint64_t workload::iterations_for(nanoseconds d) const
+{
+    if (d.count() <= 0) return 0;
+    return (std::uint64_t)((double)d.count() / ns_per_iter_ + 0.5);
+}
+
+void workload::run(nanoseconds d)
+{
+    if (kind_ == workload_kind::sleep) {
+        if (d.count() > 0) stop_.sleep_for(d);
+        return;
+    }
+
+    std::uint64_t iters = iterations_for(d);
+    if (!stop_.stop_possible()) {
+        step(iters);
+        return;
+    }
+    const std::uint64_t slice = std::max<std::uint64_t>(1, iterations_for(stop_check_slice));
+    while (iters > 0 && !stop_.stop_requested()) {
+        std::uint64_t n = std::min(iters, slice);
+        step(n);
+        iters -= n;
+    }
+}
+
+void workload::step(std::uint64_t iters)
+{
+    std::uint64_t s = state_;
+    std::size_t c = cursor_;
+
+    switch (kind_) {
+    case workload_kind::sleep:
+        return;
+
+    case workload_kind::spin:
+        for (std::uint64_t i = 0; i < iters; i++) {
+            s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+            s ^= s >> 29;
+        }
+        break;
+
+    case workload_kind::hash:
+        for (std::uint64_t i = 0; i < iters; i++) {
+            std::uint64_t h = 0xcbf29ce484222325ULL ^ s;
+            for (std::size_t w = 0; w < line_words; w++) {
+                h ^= data_[c + w];
+                h *= 0x100000001b3ULL;
+            }
+            s = h;
+            c = (c + line_words) & (hash_block_words - 1);
+        }
+        break;
+
+    case workload_kind::memory: {
+        const std::size_t n = data_.size();
+        for (std::uint64_t i = 0; i < iters; i++) {
+            std::uint64_t sum = 0;
+            for (std::size_t w = 0; w < line_words; w++) sum += data_[c + w];
+            data_[c] = sum + 1;
+            s += sum;
+            c += line_words;
+            if (c >= n) c = 0;
+        }
+        break;
+    }
+
+    case workload_kind::pointer_chase:
+        for (std::uint64_t i = 0; i < iters; i++) c = (std::size_t)data_[c];
+        s += c;
+        break;
+    }
+
+    state_ = s;
+    cursor_ = c;
+}
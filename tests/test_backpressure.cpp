@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "spsc_ring.h"
+#include "mpmc_queue.h"
+#include "pipeline.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Produtor parado: publish_batch nunca espera por ele
+struct idle_producer : public thread_base {
+    void run() override {}
+};
+
+std::vector<int> drain(channel<int> &q)
+{
+    std::vector<int> out;
+    int v;
+    while (q.try_pop(v)) out.push_back(v);
+    return out;
+}
+
+const int items[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+}
+
+/**
+ * @brief drop_newest descarta o que não cabe, sem esperar
+ */
+TEST(Backpressure, DropNewestKeepsPrefix) {
+    idle_producer p;
+    spsc_ring<int> q(4);
+    EXPECT_EQ(q.publish_batch(items, 6, p, overflow_policy::drop_newest), 6u);
+    EXPECT_EQ(drain(q), (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(q.backpressure().dropped_newest, 2u);
+    EXPECT_EQ(q.backpressure().blocked, 0u);
+}
+
+/**
+ * @brief drop_oldest remove os mais antigos; em fila SPSC age como drop_newest
+ */
+TEST(Backpressure, DropOldestKeepsNewest) {
+    idle_producer p;
+    mpmc_queue<int> q(4);
+    EXPECT_EQ(q.publish_batch(items, 6, p, overflow_policy::drop_oldest), 6u);
+    EXPECT_EQ(drain(q), (std::vector<int>{2, 3, 4, 5}));
+    EXPECT_EQ(q.backpressure().dropped_oldest, 2u);
+
+    spsc_ring<int> single(4);
+    EXPECT_FALSE(single.evictable());
+    single.publish_batch(items, 6, p, overflow_policy::drop_oldest);
+    EXPECT_EQ(drain(single), (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(single.backpressure().dropped_newest, 2u);
+}
+
+/**
+ * @brief sample admite 1 em N acima de meia fila, espalhando as perdas
+ */
+TEST(Backpressure, SampleAdmitsOneInN) {
+    idle_producer p;
+    spsc_ring<int> q(8);
+    q.set_sample_every(4);
+    EXPECT_EQ(q.publish_batch(items, 20, p, overflow_policy::sample), 20u);
+    EXPECT_EQ(drain(q), (std::vector<int>{0, 1, 2, 3, 4, 8, 12, 16}));
+    EXPECT_EQ(q.backpressure().sampled_out, 12u);
+    EXPECT_EQ(q.backpressure().dropped(), 12u);
+}
+
+/**
+ * @brief block com produtor parado não insere nem conta perdas
+ */
+TEST(Backpressure, BlockNeverDrops) {
+    idle_producer p;
+    spsc_ring<int> q(2);
+    EXPECT_EQ(q.publish_batch(items, 4, p), 2u);
+    EXPECT_EQ(q.backpressure().dropped(), 0u);
+}
+
+/**
+ * @brief Políticas por aresta no Pipeline; aresta desconhecida é rejeitada
+ *
+ * Consumidores lentos (200ms por item) com filas de 2 posições: a source
+ * descarta em vez de esperar.
+ */
+TEST(Backpressure, PipelineDropsUnderOverload) {
+    BenchConfig cfg;
+    cfg.edge_backpressure["sA:pcB"] = "drop_newest";
+    EXPECT_THROW(PipelineBuilder::standard(&cfg).edge_policies(), std::invalid_argument);
+
+    cfg.edge_backpressure.clear();
+    cfg.backpressure = "drop_newest";
+    cfg.edge_backpressure["sA:sB"] = "drop_oldest";
+    PipelineBuilder b = PipelineBuilder::standard(&cfg);
+    std::vector<overflow_policy> policies = b.edge_policies();
+    ASSERT_EQ(policies.size(), 3u);
+    EXPECT_EQ(policies[0], overflow_policy::drop_newest);   // sA -> pcA
+    EXPECT_EQ(policies[1], overflow_policy::drop_oldest);   // sA -> sB
+
+    cfg.queue_capacity = 2;
+    cfg.work_us = 200000;
+    Pipeline pipe(&cfg);
+    pipe.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    pipe.stop();
+
+    backpressure_stats s = pipe.backpressure();
+    EXPECT_GT(s.dropped_newest, 0u);
+    EXPECT_EQ(s.blocked, 0u);
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <unistd.h>
 
+#include "profile_zones.h"
+
 #ifndef TEST_BIN_PATH
 #error TEST_BIN_PATH not defined
 #endif
@@ -47,3 +49,26 @@ TEST(CLI, WritesFiles) {
     remove(out.c_str());
     remove(prof.c_str());
 }
+
+TEST(CLI, ZoneReportWithoutRawEvents) {
+    if(profile_level < profile_level_stage) GTEST_SKIP() << "zones compiled out (PROFILE_LEVEL=0)";
+
+    std::string out = mktemp_file("/tmp/results-XXXXXX.csv");
+    std::string report = mktemp_file("/tmp/zones-XXXXXX.txt");
+
+    std::string cmd = get_bin() + " --duration-ms 300 --work-us 0 --out " + out + " --profile-report " + report + " > /dev/null";
+    int ret = system(cmd.c_str());
+    EXPECT_EQ(ret, 0);
+
+    FILE *f = fopen(report.c_str(), "r");
+    ASSERT_NE(f, nullptr);
+    std::string text;
+    char line[256];
+    while(fgets(line, sizeof(line), f)) text += line;
+    fclose(f);
+    EXPECT_NE(text.find("zone"), std::string::npos);
+    EXPECT_NE(text.find("bottleneck"), std::string::npos);
+
+    remove(out.c_str());
+    remove(report.c_str());
+}
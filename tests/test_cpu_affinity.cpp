@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "cpu_affinity.h"
+#include "pipeline.h"
+#include "bench_metrics.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+/// Dois núcleos com SMT, numeração do Linux: CPUs 0/2 e 1/3 são irmãs
+cpu_topology two_cores_smt()
+{
+    return cpu_topology({ {0, 0, 0, 0}, {1, 1, 0, 0}, {2, 0, 0, 0}, {3, 1, 0, 0} });
+}
+}
+
+/**
+ * @brief Listas no formato do sysfs/taskset
+ */
+TEST(CpuAffinity, ParsesCpuLists) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(parse_cpu_list("0-3,8,10-11", cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_TRUE(parse_cpu_list("5,1,5", cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{1, 5}));
+
+    EXPECT_FALSE(parse_cpu_list("", cpus));
+    EXPECT_FALSE(parse_cpu_list("3-1", cpus));
+    EXPECT_FALSE(parse_cpu_list("1,,2", cpus));
+    EXPECT_FALSE(parse_cpu_list("a", cpus));
+    EXPECT_FALSE(parse_cpu_list("-1", cpus));
+    EXPECT_FALSE(parse_cpu_list("0-2000000000", cpus));
+    EXPECT_FALSE(parse_cpu_list(std::to_string(max_cpus), cpus));
+    EXPECT_FALSE(parse_cpu_list("99999999999999999999", cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{1, 5}));   // unchanged on error
+}
+
+/**
+ * @brief Irmãos SMT ficam lado a lado; nós NUMA não se intercalam
+ */
+TEST(CpuAffinity, PlacementOrderKeepsSiblingsTogether) {
+    EXPECT_EQ(two_cores_smt().placement_order(), (std::vector<int>{0, 2, 1, 3}));
+
+    cpu_topology numa({ {0, 0, 0, 0}, {1, 0, 1, 1}, {2, 1, 0, 0}, {3, 1, 1, 1} });
+    EXPECT_EQ(numa.node_count(), 2);
+    EXPECT_EQ(numa.node_of(3), 1);
+    EXPECT_EQ(numa.node_of(9), -1);
+    EXPECT_EQ(numa.placement_order(), (std::vector<int>{0, 2, 1, 3}));
+}
+
+/**
+ * @brief "auto" segue as arestas: sA -> sB -> pcB em CPUs vizinhas, pcA depois
+ */
+TEST(CpuAffinity, AutoPlacementFollowsDataFlow) {
+    BenchConfig cfg;
+    cfg.affinity = "auto";
+    PipelineBuilder b = PipelineBuilder::standard(&cfg);   // sA, pcA, sB, pcB
+    auto cpus = b.placement(two_cores_smt());
+
+    ASSERT_EQ(cpus.size(), 4u);
+    EXPECT_EQ(cpus[b.find("sA")][0], std::vector<int>{0});
+    EXPECT_EQ(cpus[b.find("sB")][0], std::vector<int>{2});
+    EXPECT_EQ(cpus[b.find("pcB")][0], std::vector<int>{1});
+    EXPECT_EQ(cpus[b.find("pcA")][0], std::vector<int>{3});
+
+    cfg.affinity = "none";
+    cfg.stage_affinity["pcB"] = "1-2";
+    cpus = b.placement(two_cores_smt());
+    EXPECT_TRUE(cpus[b.find("sA")][0].empty());
+    EXPECT_EQ(cpus[b.find("pcB")][0], (std::vector<int>{1, 2}));
+}
+
+/**
+ * @brief Modo, estágio ou lista de CPUs inválidos são rejeitados
+ */
+TEST(CpuAffinity, RejectsInvalidSettings) {
+    BenchConfig cfg;
+    PipelineBuilder b = PipelineBuilder::standard(&cfg);
+
+    cfg.affinity = "sideways";
+    EXPECT_THROW(b.placement(two_cores_smt()), std::invalid_argument);
+
+    cfg.affinity = "none";
+    cfg.stage_affinity["pcC"] = "0";
+    EXPECT_THROW(b.placement(two_cores_smt()), std::invalid_argument);
+
+    cfg.stage_affinity.clear();
+    cfg.stage_affinity["pcA"] = "0-";
+    EXPECT_THROW(b.placement(two_cores_smt()), std::invalid_argument);
+}
+
+#if CPU_AFFINITY_SUPPORTED
+/**
+ * @brief Pipeline com afinidade automática fixa as threads e continua processando;
+ * a máscara lida de dentro de cada estágio é a planejada
+ */
+TEST(CpuAffinity, PinnedPipelineRuns) {
+    BenchConfig cfg;
+    cfg.affinity = "auto";
+    PipelineBuilder b = PipelineBuilder::standard(&cfg);
+    std::vector<std::vector<int>> planned;
+    for (const auto &stage : b.placement(cpu_topology::detect()))
+        planned.insert(planned.end(), stage.begin(), stage.end());
+
+    reset_processed_items();
+    Pipeline p(b);
+    p.start();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    auto all_started = [&] {
+        for (const auto &cpus : p.running_cpus()) {
+            if (cpus.empty()) return false;
+        }
+        return true;
+    };
+    while ((get_processed_items() < 1 || !all_started()) && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<std::vector<int>> running = p.running_cpus();
+    p.stop();
+
+    EXPECT_GE(get_processed_items(), 1);
+    ASSERT_EQ(running.size(), planned.size());
+    for (std::size_t i = 0; i < planned.size(); i++) {
+        ASSERT_FALSE(planned[i].empty());
+        EXPECT_EQ(running[i], planned[i]) << "instance " << i;
+    }
+}
+#endif
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "latency_histogram.h"
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Valor e limite superior do bucket ficam a menos de 1/32 um do outro
+ */
+TEST(LatencyHistogram, BucketPrecision) {
+    for (unsigned long long v : {0ULL, 1ULL, 63ULL, 64ULL, 65ULL, 1000ULL, 123456789ULL, 1ULL << 40, ~0ULL}) {
+        std::size_t idx = latency_histogram::bucket_of(v);
+        ASSERT_LT(idx, latency_histogram::bucket_count);
+        unsigned long long upper = latency_histogram::bucket_upper(idx);
+        EXPECT_GE(upper, v);
+        EXPECT_LE((double)(upper - v), (double)v / 32.0);
+    }
+    EXPECT_EQ(latency_histogram::bucket_of(~0ULL), latency_histogram::bucket_count - 1);
+}
+
+/**
+ * @brief Percentis de uma distribuição conhecida
+ */
+TEST(LatencyHistogram, Percentiles) {
+    latency_histogram h;
+    EXPECT_EQ(h.percentile(0.5), 0);
+
+    for (long long v = 1; v <= 1000; v++) h.record(v * 1000);   // 1us..1ms
+
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.max(), 1000000);
+    EXPECT_NEAR((double)h.percentile(0.50), 500000.0, 500000.0 / 32);
+    EXPECT_NEAR((double)h.percentile(0.99), 990000.0, 990000.0 / 32);
+    EXPECT_EQ(h.percentile(1.0), 1000000);
+
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.max(), 0);
+}
+
+/**
+ * @brief Registro concorrente sem perda de amostras
+ */
+TEST(LatencyHistogram, ConcurrentRecord) {
+    latency_histogram h;
+    const int THREADS = 4;
+    const int SAMPLES = 20000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; t++) {
+        workers.emplace_back([&h, t] {
+            for (int i = 0; i < SAMPLES; i++) h.record((long long)(t + 1) * 1000 + i);
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    EXPECT_EQ(h.count(), (unsigned long long)THREADS * SAMPLES);
+    EXPECT_EQ(h.max(), (long long)THREADS * 1000 + SAMPLES - 1);
+}
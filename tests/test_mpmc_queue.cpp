@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "mpmc_queue.h"
+#include "pipeline.h"
+#include "bench_metrics.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(MpmcQueue, FullAndEmpty) {
+    mpmc_queue<int> q(4);
+    int v = 0;
+    EXPECT_EQ(q.capacity(), 4u);
+    EXPECT_FALSE(q.try_pop(v));
+
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(q.try_push(i));
+    EXPECT_FALSE(q.try_push(99));
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(q.try_pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+/**
+ * @brief Vários produtores e consumidores simultâneos
+ * 
+ * Cada valor deve ser consumido exatamente uma vez
+ */
+TEST(MpmcQueue, EveryItemConsumedOnce) {
+    const int PRODUCERS = 4;
+    const int CONSUMERS = 4;
+    const int PER_PRODUCER = 20000;
+    const int TOTAL = PRODUCERS * PER_PRODUCER;
+
+    mpmc_queue<int> q(64);
+    std::vector<std::atomic<int>> seen(TOTAL);
+    for (auto &s : seen) s.store(0);
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < PER_PRODUCER; i++) {
+                while (!q.try_push(p * PER_PRODUCER + i)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&]() {
+            int v;
+            while (consumed.load() < TOTAL) {
+                if (q.try_pop(v)) {
+                    seen[v].fetch_add(1);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    for (int i = 0; i < TOTAL; i++) ASSERT_EQ(seen[i].load(), 1) << "item " << i;
+}
+
+/**
+ * @brief Pipeline com vários source_B e process_B
+ */
+TEST(MpmcQueue, PipelineFanOut) {
+    reset_processed_items();
+
+    BenchConfig cfg;
+    cfg.producers = 2;
+    cfg.consumers = 3;
+    Pipeline pipeline(&cfg);
+    pipeline.start();
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (get_processed_items() < 3 &&
+           std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    pipeline.stop();
+    EXPECT_GE(get_processed_items(), 3);
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "payload.h"
+#include "spsc_ring.h"
+#include "source_threads.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+struct big_payload
+{
+    int id;
+    unsigned char body[8192];
+};
+}
+
+/**
+ * @brief Cópias compartilham o objeto; o último handle devolve ao pool
+ */
+TEST(Payload, HandlesShareAndRecycle) {
+    payload_pool<big_payload> pool(2);
+    EXPECT_EQ(pool.available(), 2u);
+
+    payload_handle<big_payload> a = pool.acquire();
+    a->id = 7;
+    EXPECT_EQ(pool.available(), 1u);
+
+    payload_handle<big_payload> b = a;
+    EXPECT_EQ(b.get(), a.get());
+    EXPECT_EQ(a.use_count(), 2);
+
+    a.reset();
+    EXPECT_FALSE(a);
+    EXPECT_EQ(pool.available(), 1u);
+    EXPECT_EQ(b->id, 7);
+
+    b.reset();
+    EXPECT_EQ(pool.available(), 2u);
+    EXPECT_EQ(pool.overflow(), 0u);
+}
+
+/**
+ * @brief Pool esgotado recorre a new, sem falhar
+ */
+TEST(Payload, OverflowFallsBackToHeap) {
+    payload_pool<big_payload> pool(1);
+    payload_handle<big_payload> a = pool.acquire();
+    payload_handle<big_payload> b = pool.acquire();
+    ASSERT_TRUE(b);
+    EXPECT_NE(a.get(), b.get());
+    EXPECT_EQ(pool.overflow(), 1u);
+
+    b.reset();   // heap object is deleted, not pooled
+    EXPECT_EQ(pool.available(), 0u);
+    a.reset();
+    EXPECT_EQ(pool.available(), 1u);
+}
+
+/**
+ * @brief Só o handle cruza a fila: consumidor vê o mesmo objeto
+ *
+ * A remoção move o handle para fora da fila, que não segura referência.
+ */
+TEST(Payload, QueueCarriesPointerOnly) {
+    payload_pool<big_payload> pool(4);
+    spsc_ring<payload_handle<big_payload>> ring(4);
+
+    payload_handle<big_payload> h = pool.acquire();
+    big_payload *p = h.get();
+    ASSERT_TRUE(ring.try_push(h));
+    h.reset();
+    EXPECT_EQ(pool.available(), 3u);
+
+    payload_handle<big_payload> out;
+    ASSERT_TRUE(ring.try_pop(out));
+    EXPECT_EQ(out.get(), p);
+    EXPECT_EQ(out.use_count(), 1);
+    out.reset();
+    EXPECT_EQ(pool.available(), 4u);
+}
+
+/**
+ * @brief Aquisição e devolução concorrentes mantêm o pool íntegro
+ */
+TEST(Payload, ConcurrentAcquireRelease) {
+    payload_pool<big_payload> pool(16);
+    std::vector<std::thread> threads;
+    std::atomic<int> bad{0};
+
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20000; i++) {
+                payload_handle<big_payload> h = pool.acquire();
+                h->id = t;
+                payload_handle<big_payload> copy = h;
+                if (copy->id != t) bad++;
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+
+    EXPECT_EQ(bad.load(), 0);
+    EXPECT_EQ(pool.available(), 16u);
+}
+
+/**
+ * @brief source_A entrega quadros do pool; os handles voltam após o consumo
+ */
+TEST(Payload, SourceAFramesComeFromPool) {
+    source_A source;
+    channel<item_A> *ring = source.subscribe();
+    source.start();
+
+    item_A frame;
+    while (!ring->pop_wait(frame)) {}
+    EXPECT_EQ(frame->head.seq, 1u);
+    EXPECT_EQ(frame->body[0], (unsigned char)(frame->head.data & 0xff));
+    frame.reset();
+    source.stop();
+
+    EXPECT_EQ(source.frames().overflow(), 0u);
+    EXPECT_EQ(source.frames().available() + ring->size(), source.frames().capacity());
+}
+
+/**
+ * @brief Liberados por outro thread voltam ao cache de quem adquiriu
+ *
+ * O produtor recolhe a lista remote-free e volta a usar os mesmos
+ * objetos, sem esgotar o slab.
+ */
+TEST(Payload, RemoteFreesReturnToProducer) {
+    payload_pool<big_payload> pool(8);
+    spsc_ring<payload_handle<big_payload>> ring(2);
+    const int N = 5000;
+
+    std::thread consumer([&] {
+        int got = 0;
+        payload_handle<big_payload> h;
+        while (got < N) {
+            if (ring.try_pop(h)) {
+                h.reset();
+                got++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < N; i++) {
+        payload_handle<big_payload> h = pool.acquire();
+        h->id = i;
+        while (!ring.try_push(h)) std::this_thread::yield();
+    }
+    consumer.join();
+
+    payload_pool_stats s = pool.stats();
+    EXPECT_EQ(s.heap_allocs, 0u);
+    EXPECT_EQ(s.acquired, (std::uint64_t)N);
+    EXPECT_EQ(s.remote_frees, (std::uint64_t)N);
+    EXPECT_EQ(pool.available(), 8u);
+}
+
+/**
+ * @brief O cache de um thread encerrado é adotado pelo próximo
+ */
+TEST(Payload, ExitedThreadCacheIsAdopted) {
+    payload_pool<big_payload> pool(2);
+    for (int run = 0; run < 10; run++) {
+        std::thread t([&] {
+            payload_handle<big_payload> a = pool.acquire();
+            payload_handle<big_payload> b = pool.acquire();
+        });
+        t.join();
+    }
+
+    payload_pool_stats s = pool.stats();
+    EXPECT_EQ(s.heap_allocs, 0u);
+    EXPECT_EQ(s.thread_caches, 1u);
+    EXPECT_EQ(pool.available(), 2u);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "pipeline.h"
 #include "bench_metrics.h"
+#include <chrono>
+#include <thread>
 
 TEST(Pipeline, StartStopNoCrash) {
     reset_processed_items();
@@ -17,3 +19,207 @@ TEST(Pipeline, StartStopNoCrash) {
     long long p = get_processed_items();
     EXPECT_GE(p, 0);
 }
+
+TEST(Pipeline, BatchedStagesProcessItems) {
+    reset_processed_items();
+
+    BenchConfig cfg;
+    cfg.batch_size = 8;
+    Pipeline mt(&cfg);
+    mt.start();
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (get_processed_items() < 2 &&
+           std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    mt.stop();
+    EXPECT_GE(get_processed_items(), 2);
+}
+
+TEST(Pipeline, RecordsLatencies) {
+    reset_processed_items();
+
+    BenchConfig cfg;
+    Pipeline mt(&cfg);
+    mt.start();
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (mt.metrics().end_to_end.count() < 2 &&
+           std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    mt.stop();
+
+    const pipeline_metrics &m = mt.metrics();
+    EXPECT_GE(m.sA.count(), 1u);
+    EXPECT_GE(m.sB.count(), 1u);
+    EXPECT_GE(m.pcB.count(), 1u);
+    ASSERT_GE(m.end_to_end.count(), 2u);
+
+    // sA dorme 45ms; source_B publica após 10+2ms e process_B leva 57ms
+    EXPECT_GE(m.sA.percentile(0.5), 45000000LL);
+    EXPECT_GE(m.end_to_end.percentile(0.5), 57000000LL + 12000000LL);
+    EXPECT_LE(m.end_to_end.percentile(0.5), m.end_to_end.max());
+}
+
+/**
+ * @brief Quadros vêm dos slabs do Pipeline, sem recorrer ao heap
+ */
+TEST(Pipeline, FramesComeFromSlab) {
+    reset_processed_items();
+
+    BenchConfig cfg;
+    Pipeline mt(&cfg);
+    mt.start();
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (get_processed_items() < 2 &&
+           std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    mt.stop();
+
+    payload_pool_stats s = mt.frame_stats();
+    EXPECT_GT(s.capacity, 0u);
+    EXPECT_GE(s.acquired, 4u);   // >= 2 frame_A and 2 frame_B
+    EXPECT_GT(s.remote_frees, 0u);
+    EXPECT_EQ(s.heap_allocs, 0u);
+}
+
+/**
+ * @brief No thread_pool os quadros também vêm só dos slabs
+ *
+ * Cada tarefa de um estágio pode executar num worker diferente; os quadros
+ * liberados precisam voltar ao produtor, não ao worker onde foram adquiridos.
+ * Mais workers que estágios, filas pequenas e descarte na aresta lenta fazem
+ * os estágios trocarem de worker e os quadros darem várias voltas no slab.
+ */
+TEST(Pipeline, FramesComeFromSlabOnPool) {
+    BenchConfig cfg;
+    cfg.executor = "pool";
+    cfg.threads = 8;
+    cfg.queue_capacity = 2;
+    cfg.edge_backpressure["sA:pcA"] = "drop_newest";
+    Pipeline mt(&cfg);
+    mt.start();
+
+    const std::size_t capacity = mt.frame_stats().capacity;
+    auto t0 = std::chrono::steady_clock::now();
+    while (mt.frame_stats().acquired < 3 * capacity &&
+           std::chrono::steady_clock::now() - t0 < std::chrono::seconds(8)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    mt.stop();
+
+    payload_pool_stats s = mt.frame_stats();
+    EXPECT_GE(s.acquired, 3 * s.capacity);
+    EXPECT_EQ(s.heap_allocs, 0u);
+}
+
+/**
+ * @brief pause()/reset()/resume() reaproveitam as threads entre execuções
+ *
+ * Após reset() as filas estão vazias, os quadros voltaram aos slabs e as
+ * latências foram zeradas; a execução seguinte processa normalmente.
+ */
+TEST(Pipeline, PauseResetResume) {
+    auto wait_processed = [](long long n) {
+        auto t0 = std::chrono::steady_clock::now();
+        while (get_processed_items() < n && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(3))
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+
+    reset_processed_items();
+    BenchConfig cfg;
+    Pipeline mt(&cfg);
+    mt.start();
+    wait_processed(2);
+    mt.pause();
+
+    long long frozen = get_processed_items();
+    EXPECT_GE(frozen, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(get_processed_items(), frozen);
+
+    mt.reset();
+    EXPECT_EQ(mt.metrics().end_to_end.count(), 0u);
+    reset_processed_items();
+
+    for (int run = 0; run < 3; run++) {
+        mt.resume();
+        wait_processed(1);
+        mt.pause();
+        EXPECT_GE(get_processed_items(), 1);
+        mt.reset();
+        reset_processed_items();
+    }
+    mt.stop();
+
+    EXPECT_EQ(mt.frame_stats().heap_allocs, 0u);
+}
+
+/**
+ * @brief stop() interrompe esperas e trabalho simulado (process_A dorme 250ms por ciclo)
+ */
+TEST(Pipeline, StopCancelsPromptly) {
+    reset_processed_items();
+    BenchConfig cfg;
+    Pipeline mt(&cfg);
+    mt.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    shutdown_report r = mt.stop();
+    EXPECT_LT(r.latency, std::chrono::milliseconds(100));
+    EXPECT_EQ(r.drain.count(), 0);
+    EXPECT_FALSE(r.drain_timed_out);
+}
+
+/**
+ * @brief stop(drain) processa o que está em fila antes de parar
+ */
+TEST(Pipeline, DrainFlushesQueues) {
+    reset_processed_items();
+    BenchConfig cfg;
+    cfg.queue_capacity = 2;
+    Pipeline mt(&cfg);
+    mt.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    shutdown_report r = mt.stop(stop_mode::drain);
+    EXPECT_FALSE(r.drain_timed_out);
+    EXPECT_EQ(r.discarded, 0u);
+    EXPECT_GT(r.drain.count(), 0);
+    EXPECT_GE(r.latency, r.drain);
+    EXPECT_GE(get_processed_items(), 1);
+
+    stop_mode m;
+    EXPECT_TRUE(stop_mode_from_string("drain", m));
+    EXPECT_EQ(m, stop_mode::drain);
+    EXPECT_FALSE(stop_mode_from_string("abort", m));
+}
+
+/**
+ * @brief Ciclo interrompido por pause() não vira amostra de latência
+ *
+ * process_A trabalha 250ms por ciclo; a pausa chega no meio do primeiro.
+ */
+TEST(Pipeline, PausedCycleIsNotRecorded) {
+    reset_processed_items();
+    BenchConfig cfg;
+    Pipeline mt(&cfg);
+    mt.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    mt.pause();
+    EXPECT_EQ(mt.metrics().pcA.count(), 0u);
+
+    // Uninterrupted cycles are still recorded
+    mt.resume();
+    auto t0 = std::chrono::steady_clock::now();
+    while (mt.metrics().pcA.count() == 0 && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(3))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    mt.stop();
+    EXPECT_GT(mt.metrics().pcA.count(), 0u);
+}
@@ -5,7 +5,15 @@
 TEST(ProcessBuffer, IncrementsProcessed) {
     reset_processed_items();
     process_B b;
-    int val = 0;
-    b.process_buffer(&val);
+    frame_B frame = {};
+    b.process_buffer(frame);
     EXPECT_GE(get_processed_items(), 1);
 }
+
+TEST(ProcessBuffer, BatchCountsEveryItem) {
+    reset_processed_items();
+    process_B b;
+    frame_B frame = {};
+    for (int i = 0; i < 4; i++) b.process_buffer(frame);
+    EXPECT_EQ(get_processed_items(), 4);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "bench_metrics.h"
+#include <thread>
+#include <vector>
 
 TEST(BenchMetrics, IncrementAndReset) {
     reset_processed_items();
@@ -11,3 +13,27 @@ TEST(BenchMetrics, IncrementAndReset) {
     reset_processed_items();
     EXPECT_EQ(get_processed_items(), 0);
 }
+
+TEST(BenchMetrics, ConcurrentIncrementsAggregate) {
+    reset_processed_items();
+
+    const int THREADS = 8;
+    const int INCREMENTS = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; t++) {
+        workers.emplace_back([] {
+            for (int i = 0; i < INCREMENTS; i++) inc_processed_items();
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    EXPECT_EQ(get_processed_items(), (long long)THREADS * INCREMENTS);
+
+    reset_processed_items();
+    EXPECT_EQ(get_processed_items(), 0);
+}
+
+TEST(BenchMetrics, ShardsArePadded) {
+    sharded_counter c;
+    EXPECT_GE(sizeof(c), sharded_counter::shard_count * cache_line_size);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "profile_clock.h"
+#include "profile_print.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+long long steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+/**
+ * @brief Fonte padrão é steady_clock, monotônica e já em nanosegundos
+ */
+TEST(ProfileClock, SteadyByDefault) {
+    ASSERT_EQ(profile_clock::source(), profile_clock_source::steady);
+
+    long long a = profile_clock::now();
+    long long ref = steady_ns();
+    long long b = profile_clock::now();
+    EXPECT_LE(a, b);
+    EXPECT_EQ(profile_clock::to_ns(a), a);
+    EXPECT_LE(a, ref);
+    EXPECT_LE(ref, b);
+}
+
+/**
+ * @brief Modo TSC: ticks convertidos acompanham steady_clock
+ */
+TEST(ProfileClock, TscMatchesSteady) {
+    if (!profile_clock::tsc_available()) {
+        EXPECT_FALSE(ProfilePrinter::get().set_clock(profile_clock_source::tsc));
+        EXPECT_EQ(profile_clock::source(), profile_clock_source::steady);
+        return;
+    }
+
+    ASSERT_TRUE(ProfilePrinter::get().set_clock(profile_clock_source::tsc));
+    EXPECT_EQ(profile_clock::source(), profile_clock_source::tsc);
+
+    long long t0 = profile_clock::now();
+    long long ref0 = steady_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    long long t1 = profile_clock::now();
+    long long ref1 = steady_ns();
+
+    long long ns0 = profile_clock::to_ns(t0);
+    long long ns1 = profile_clock::to_ns(t1);
+    EXPECT_LT(ns0, ns1);
+    EXPECT_NEAR((double)(ns1 - ns0), (double)(ref1 - ref0), 2e6);   // 2ms de tolerância
+    EXPECT_NEAR((double)ns1, (double)ref1, 2e6);
+
+    ASSERT_TRUE(ProfilePrinter::get().set_clock(profile_clock_source::steady));
+    EXPECT_EQ(profile_clock::source(), profile_clock_source::steady);
+}
+
+/**
+ * @brief Recalibrar o TSC enquanto outra thread converte: cada conversão usa
+ * uma calibração inteira (nunca base de uma e taxa de outra)
+ */
+TEST(ProfileClock, RecalibrateWhileConverting) {
+    if (!profile_clock::tsc_available()) GTEST_SKIP() << "no invariant TSC";
+    ASSERT_TRUE(profile_clock::select(profile_clock_source::tsc));
+
+    std::atomic<bool> done{false};
+    int off = 0;
+    std::thread reader([&] {
+        while (!done.load()) {
+            long long ref0 = steady_ns();
+            long long ns = profile_clock::to_ns(profile_clock::now());
+            long long ref1 = steady_ns();
+            if (ns < ref0 - 2000000 || ns > ref1 + 2000000) off++;
+        }
+    });
+    for (int i = 0; i < 3; i++) EXPECT_TRUE(profile_clock::select(profile_clock_source::tsc));
+    done = true;
+    reader.join();
+    EXPECT_EQ(off, 0);
+
+    ASSERT_TRUE(profile_clock::select(profile_clock_source::steady));
+}
@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+#include "profile_print.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+/// Linhas do arquivo que começam com prefix
+int count_lines(const std::string &path, const std::string &prefix)
+{
+    std::ifstream in(path);
+    std::string line;
+    int n = 0;
+    while (std::getline(in, line)) {
+        if (line.compare(0, prefix.size(), prefix) == 0) n++;
+    }
+    return n;
+}
+}
+
+/**
+ * @brief Eventos de várias threads chegam ao arquivo após flush()
+ *
+ * start()/stop() geram duas linhas cada, como no formato original.
+ */
+TEST(ProfilePrint, ThreadsWriteThroughRings) {
+    std::string path = "/tmp/profile_rings_test.csv";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+
+    const int THREADS = 4;
+    const int ZONES = 100;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; t++) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < ZONES; i++) {
+                p.start("ring_zone");
+                p.stop("ring_zone");
+            }
+            p.write_line("ring_line", 1, 1);
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    p.flush();
+    p.mute();
+
+    EXPECT_EQ(count_lines(path, "thread,"), 1);
+    EXPECT_EQ(count_lines(path, "ring_zone,"), THREADS * ZONES * 4);
+    EXPECT_EQ(count_lines(path, "ring_line,1,1"), THREADS);
+
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Com o anel cheio, eventos são descartados e contados (sem bloquear)
+ */
+TEST(ProfilePrint, FullRingDropsEvents) {
+    std::string path = "/tmp/profile_drop_test.csv";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+
+    unsigned long long before = p.dropped_events();
+    std::thread burst([&] {
+        for (std::size_t i = 0; i < 2 * profile_ring_capacity; i++)
+            p.write_line("drop_test", (long long)i, 0);
+    });
+    burst.join();
+
+    p.flush();
+    p.mute();
+
+    unsigned long long dropped = p.dropped_events() - before;
+    int written = count_lines(path, "drop_test,");
+    EXPECT_EQ((unsigned long long)written + dropped, 2 * profile_ring_capacity);
+    EXPECT_GE(written, (int)profile_ring_capacity);
+
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Zonas registradas são gravadas pelo nome da tabela, sem strings no registro
+ */
+TEST(ProfilePrint, ScopedZonesUseRegisteredNames) {
+    std::string path = "/tmp/profile_zones_test.csv";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+
+    std::thread worker([] {
+        for (int i = 0; i < 3; i++) {
+            profile_zone<zone_id::pcB> stage;
+            profile_zone<zone_id::sB_prep> detail;
+        }
+    });
+    worker.join();
+
+    p.flush();
+    p.mute();
+
+    EXPECT_EQ(count_lines(path, "pcB,"), zone_enabled(zone_id::pcB) ? 3 * 4 : 0);
+    EXPECT_EQ(count_lines(path, "sB_prep,"), zone_enabled(zone_id::sB_prep) ? 3 * 4 : 0);
+
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Zonas acima de PROFILE_LEVEL não geram código: objeto vazio e trivial
+ */
+TEST(ProfilePrint, DisabledZonesCompileAway) {
+    static_assert(std::is_trivially_destructible<profile_zone<zone_id::sA, false>>::value,
+                  "a disabled zone must not run anything on scope exit");
+    static_assert(!std::is_trivially_destructible<profile_zone<zone_id::sA, true>>::value,
+                  "an enabled zone records on scope exit");
+
+    EXPECT_EQ(zone_level(zone_id::pcA), profile_level_stage);
+    EXPECT_EQ(zone_level(zone_id::sA_read), profile_level_detail);
+    EXPECT_EQ(zone_level(zone_id::pcA_wait), profile_level_detail);
+    EXPECT_EQ(zone_wait_of(zone_id::pcB), zone_id::pcB_wait);
+    EXPECT_EQ(zone_wait_of(zone_id::sA), zone_id::count);
+    EXPECT_TRUE(zone_waits(zone_id::sB_wait));
+    EXPECT_STREQ(zone_name(zone_id::sA_prep), "sA_prep");
+    EXPECT_EQ(zone_enabled(zone_id::sB_read), PROFILE_LEVEL >= profile_level_detail);
+}
+
+namespace {
+/// Grava n zonas pcB numa thread nova, com pause entre elas
+void record_zones(int n, std::chrono::microseconds gap = std::chrono::microseconds(0))
+{
+    std::thread worker([&] {
+        for (int i = 0; i < n; i++) {
+            ProfilePrinter::get().start(zone_id::pcB);
+            ProfilePrinter::get().stop(zone_id::pcB);
+            if (gap.count() > 0) std::this_thread::sleep_for(gap);
+        }
+    });
+    worker.join();
+}
+}
+
+/**
+ * @brief Amostragem 1 em N, janela de captura e orçamento por segundo
+ *
+ * Zonas são aceitas ou descartadas inteiras: o arquivo só tem pares completos.
+ */
+TEST(ProfilePrint, SamplingLimitsZones) {
+    std::string path = "/tmp/profile_sampling_test.csv";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+    profile_sampling_stats before = p.sampling_stats();
+
+    profile_sampling s;
+    s.sample_every = 4;
+    p.set_sampling(s);
+    record_zones(100);
+    p.flush();
+    EXPECT_EQ(count_lines(path, "pcB,"), 25 * 4);
+    EXPECT_EQ(p.sampling_stats().sampled_out - before.sampled_out, 75u);
+
+    // Capture: nothing until triggered, then only inside the window
+    s = profile_sampling();
+    s.capture_ms = 30;
+    p.set_sampling(s);
+    record_zones(5);
+    p.trigger_capture();
+    record_zones(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    record_zones(5);
+    p.flush();
+    EXPECT_EQ(count_lines(path, "pcB,"), (25 + 3) * 4);
+    EXPECT_EQ(p.sampling_stats().outside_capture - before.outside_capture, 10u);
+
+    // Budget: at most budget_per_s zones in any second
+    s = profile_sampling();
+    s.budget_per_s = 10;
+    p.set_sampling(s);
+    record_zones(100);
+    p.flush();
+    int budgeted = count_lines(path, "pcB,") / 4 - 28;
+    EXPECT_GE(budgeted, 10);
+    EXPECT_LE(budgeted, 20);   // the burst may straddle a second boundary
+    EXPECT_EQ(p.sampling_stats().over_budget - before.over_budget, (unsigned long long)(100 - budgeted));
+
+    p.set_sampling(profile_sampling());
+    p.mute();
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Captura pedida por sinal: o handler só marca a flag e a thread de
+ * escrita abre a janela
+ */
+TEST(ProfilePrint, SignalOpensCapture) {
+    std::string path = "/tmp/profile_signal_test.csv";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+    profile_sampling s;
+    s.capture_ms = 500;
+    p.set_sampling(s);
+
+    auto previous = std::signal(SIGUSR1, [](int) { ProfilePrinter::trigger_capture_from_signal(); });
+    record_zones(2);
+    std::raise(SIGUSR1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));   // a writer drain (10ms) or more
+    record_zones(3);
+    p.flush();
+    std::signal(SIGUSR1, previous);
+
+    EXPECT_EQ(count_lines(path, "pcB,"), 3 * 4);
+
+    p.set_sampling(profile_sampling());
+    p.mute();
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Agregados por zona sem arquivo de eventos; o gargalo é a etapa com
+ * maior ocupação por thread, não a maior soma nem uma zona de detalhe
+ */
+TEST(ProfilePrint, ZoneAggregatesWithoutOutput) {
+    ProfilePrinter &p = ProfilePrinter::get();
+    p.mute();
+    p.reset_zone_stats();
+
+    std::thread worker([&] {
+        // Opened before aggregation was on: not counted
+        p.start(zone_id::pcA);
+        p.set_aggregation(true);
+        p.stop(zone_id::pcA);
+
+        for (int i = 0; i < 5; i++) {
+            p.start(zone_id::pcB_wait);
+            p.stop(zone_id::pcB_wait);
+            p.start(zone_id::pcB);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            p.stop(zone_id::pcB);
+        }
+        // Detail zone: larger than any stage, but never the bottleneck
+        p.start(zone_id::sB_prep);
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        p.stop(zone_id::sB_prep);
+    });
+    worker.join();
+
+    // Two pcA instances: more time than pcB summed, less per thread
+    for (int t = 0; t < 2; t++) {
+        std::thread replica([&] {
+            for (int i = 0; i < 3; i++) {
+                p.start(zone_id::pcA);
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                p.stop(zone_id::pcA);
+            }
+        });
+        replica.join();
+    }
+    p.set_aggregation(false);
+
+    zone_report r = p.zone_stats();
+    EXPECT_GT(r.elapsed_ns, 31e6);
+    ASSERT_EQ(r.zones.size(), 4u);
+    EXPECT_EQ(r.zones[0].zone, zone_id::sB_prep);
+    EXPECT_EQ(r.zones[1].zone, zone_id::pcA);
+    EXPECT_EQ(r.zones[1].threads, 2u);
+    EXPECT_EQ(r.zones[1].count, 6u);
+    EXPECT_EQ(r.zones[2].zone, zone_id::pcB);
+    EXPECT_EQ(r.zones[2].threads, 1u);
+    EXPECT_EQ(r.zones[2].count, 5u);
+    EXPECT_GE(r.zones[2].min_ns, 2e6);
+    EXPECT_GE(r.zones[2].max_ns, r.zones[2].mean_ns());
+    EXPECT_GE(r.zones[2].mean_ns(), r.zones[2].min_ns);
+    EXPECT_NEAR(r.zones[2].total_ns, 5 * r.zones[2].mean_ns(), 1.0);
+    EXPECT_EQ(r.zones[3].zone, zone_id::pcB_wait);
+    EXPECT_EQ(r.zones[3].count, 5u);
+
+    std::ostringstream out;
+    write_zone_report(out, r);
+    EXPECT_NE(out.str().find("# pcB "), std::string::npos);
+    EXPECT_NE(out.str().find("pcB_wait"), std::string::npos);
+    EXPECT_NE(out.str().find("bottleneck: pcB ("), std::string::npos);
+    EXPECT_NE(out.str().find("1 threads)"), std::string::npos);
+
+    p.reset_zone_stats();
+    EXPECT_TRUE(p.zone_stats().zones.empty());
+}
+
+/**
+ * @brief Relatório sem zonas diz o motivo em vez de imprimir tabela vazia
+ */
+TEST(ProfilePrint, EmptyZoneReport) {
+    std::ostringstream out;
+    write_zone_report(out, zone_report{});
+    if (profile_level == profile_level_off)
+        EXPECT_NE(out.str().find("compiled out (PROFILE_LEVEL=0)"), std::string::npos);
+    else
+        EXPECT_NE(out.str().find("no zones recorded"), std::string::npos);
+    EXPECT_EQ(out.str().find("util_%"), std::string::npos);
+}
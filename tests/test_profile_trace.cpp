@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "profile_print.h"
+#include "profile_trace.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Codifica e decodifica eventos, incluindo status fora de 0..3
+ */
+TEST(ProfileTrace, RoundTrip) {
+    trace_encoder enc;
+    enc.begin_segment(1000);
+    enc.event(0, "sA", 1500, profile_zone_begin);
+    enc.event(0, "sA", 46500, profile_zone_end);
+    enc.event(1, "pcB", 40000, 1);     // anterior ao evento prévio: delta negativo
+    enc.event(1, "sA", 50000, 42);
+
+    std::istringstream in(enc.data());
+    trace_decoder dec(in);
+    trace_record r;
+
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(*r.name, "sA");
+    EXPECT_EQ(r.t, 1500);
+    EXPECT_EQ(r.status, profile_zone_begin);
+    EXPECT_EQ(r.thread, 0u);
+    EXPECT_EQ(r.base_t, 1000);
+
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(r.t, 46500);
+    EXPECT_EQ(r.status, profile_zone_end);
+
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(*r.name, "pcB");
+    EXPECT_EQ(r.t, 40000);
+    EXPECT_EQ(r.thread, 1u);
+
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(*r.name, "sA");
+    EXPECT_EQ(r.status, 42);
+
+    EXPECT_FALSE(dec.next(r));
+    EXPECT_FALSE(dec.failed());
+}
+
+/**
+ * @brief Segmentos concatenados (arquivo reaberto em append) continuam legíveis
+ */
+TEST(ProfileTrace, AppendedSegments) {
+    trace_encoder enc;
+    enc.begin_segment(0);
+    enc.event(0, "first", 10, 0);
+    enc.begin_segment(5000);
+    enc.event(0, "second", 5010, 1);
+
+    std::istringstream in(enc.data());
+    trace_decoder dec(in);
+    trace_record r;
+
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(r.segment, 1u);
+    EXPECT_EQ(*r.name, "first");
+    ASSERT_TRUE(dec.next(r));
+    EXPECT_EQ(r.segment, 2u);
+    EXPECT_EQ(*r.name, "second");
+    EXPECT_EQ(r.t, 5010);
+    EXPECT_FALSE(dec.next(r));
+    EXPECT_FALSE(dec.failed());
+}
+
+/**
+ * @brief Entrada que não é trace é rejeitada
+ */
+TEST(ProfileTrace, RejectsCsv) {
+    std::istringstream in("thread,time,status\nsA,1,0\n");
+    std::ostringstream out;
+    EXPECT_FALSE(trace_to_csv(in, out));
+}
+
+/**
+ * @brief Conversão CSV reproduz o formato texto; Chrome gera pares B/E
+ */
+TEST(ProfileTrace, Converters) {
+    trace_encoder enc;
+    enc.begin_segment(1000);
+    enc.event(3, "pcA", 3000, profile_zone_begin);
+    enc.event(3, "pcA", 253000, profile_zone_end);
+    enc.event(3, "mark", 254000, 1);
+
+    std::istringstream in(enc.data());
+    std::ostringstream csv;
+    ASSERT_TRUE(trace_to_csv(in, csv));
+    EXPECT_EQ(csv.str(),
+              "thread,time,status\n"
+              "pcA,3000,0\npcA,3000,1\n"
+              "pcA,253000,1\npcA,253000,0\n"
+              "mark,254000,1\n");
+
+    std::istringstream in2(enc.data());
+    std::ostringstream json;
+    ASSERT_TRUE(trace_to_chrome(in2, json));
+    EXPECT_NE(json.str().find("{\"name\":\"pcA\",\"ph\":\"B\",\"ts\":2.000,\"pid\":1,\"tid\":3}"), std::string::npos);
+    EXPECT_NE(json.str().find("{\"name\":\"pcA\",\"ph\":\"E\",\"ts\":252.000,\"pid\":1,\"tid\":3}"), std::string::npos);
+    EXPECT_NE(json.str().find("\"ph\":\"C\",\"args\":{\"status\":1}"), std::string::npos);
+}
+
+/**
+ * @brief ProfilePrinter grava trace binário bem menor que o CSV equivalente
+ */
+TEST(ProfileTrace, PrinterWritesBinary) {
+    std::string path = "/tmp/profile_trace_test.bin";
+    std::remove(path.c_str());
+
+    ProfilePrinter &p = ProfilePrinter::get();
+    EXPECT_EQ(ProfilePrinter::format_for(path), profile_format::binary);
+    EXPECT_EQ(ProfilePrinter::format_for("x.csv"), profile_format::csv);
+    ASSERT_TRUE(p.open_file(path));
+    p.unmute();
+
+    const int ZONES = 500;
+    std::thread t([&] {
+        for (int i = 0; i < ZONES; i++) {
+            p.start("sA_read");
+            p.stop("sA_read");
+        }
+    });
+    t.join();
+    p.flush();
+    p.mute();
+
+    std::ifstream in(path, std::ios::binary);
+    std::string bin((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::istringstream bin_in(bin);
+    std::ostringstream csv;
+    ASSERT_TRUE(trace_to_csv(bin_in, csv));
+
+    std::istringstream lines(csv.str());
+    std::string line;
+    int zone_lines = 0;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 8, "sA_read,") == 0) zone_lines++;
+    }
+    EXPECT_EQ(zone_lines, ZONES * 4);
+    EXPECT_LT(bin.size() * 5, csv.str().size());
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "run_window.h"
+#include <chrono>
+
+namespace {
+/// Contador que cresce 1 por milissegundo desde a criação
+struct clock_counter {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    long long operator()() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+};
+}
+
+/**
+ * @brief duration_ms tem prioridade sobre duration_s
+ */
+TEST(RunWindow, FromConfig) {
+    BenchConfig cfg;
+    cfg.duration_s = 2;
+    EXPECT_EQ(run_window::from_config(&cfg).measure, std::chrono::seconds(2));
+
+    cfg.duration_ms = 250;
+    cfg.warm_in_ms = 50;
+    cfg.interval_ms = 100;
+    run_window w = run_window::from_config(&cfg);
+    EXPECT_EQ(w.measure, std::chrono::milliseconds(250));
+    EXPECT_EQ(w.warm_in, std::chrono::milliseconds(50));
+    EXPECT_EQ(w.interval, std::chrono::milliseconds(100));
+}
+
+/**
+ * @brief Warm-in fica fora; intervalos cobrem a janela e somam o total
+ */
+TEST(RunWindow, SnapshotsAtBoundaries) {
+    run_window w;
+    w.warm_in = std::chrono::milliseconds(60);
+    w.measure = std::chrono::milliseconds(200);
+    w.interval = std::chrono::milliseconds(50);
+
+    clock_counter counter;
+    bool opened = false;
+    int reported = 0;
+    window_result r = w.run(counter, [&] { opened = true; }, [&](const interval_sample &) { reported++; });
+
+    EXPECT_TRUE(opened);
+    ASSERT_EQ(r.intervals.size(), 4u);
+    EXPECT_EQ(reported, 4);
+
+    long long sum = 0;
+    for (const auto &s : r.intervals) sum += s.processed;
+    EXPECT_EQ(sum, r.processed);
+
+    // Measured, not nominal: the window is at least as long as asked
+    EXPECT_GE(r.elapsed_s, 0.200);
+    EXPECT_LT(r.elapsed_s, 0.300);
+    EXPECT_NEAR(r.items_per_s, 1000.0, 150.0);
+    EXPECT_GE(counter(), 260);   // warm-in happened before the window
+}
+
+/**
+ * @brief Sem intervalo configurado não há amostras
+ */
+TEST(RunWindow, SingleIntervalHasNoSamples) {
+    run_window w;
+    w.measure = std::chrono::milliseconds(30);
+    clock_counter counter;
+    window_result r = w.run(counter);
+    EXPECT_TRUE(r.intervals.empty());
+    EXPECT_GE(r.processed, 29);
+}
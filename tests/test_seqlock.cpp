@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "seqlock.h"
+#include "latest_value.h"
+#include "source_threads.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Valor de várias palavras: uma leitura rasgada mistura campos diferentes
+struct wide_value
+{
+    unsigned long long a, b, c, d;
+};
+}
+
+/**
+ * @brief Leitores concorrentes nunca veem um valor rasgado nem voltam no tempo
+ */
+TEST(Seqlock, NoTornReads) {
+    seqlock<wide_value> lock;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> backwards{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&] {
+            unsigned long long last = 0;
+            while (!done.load()) {
+                wide_value v = lock.load();
+                if (v.a != v.b || v.b != v.c || v.c != v.d) torn++;
+                if (v.a < last) backwards++;
+                last = v.a;
+            }
+        });
+    }
+
+    for (unsigned long long i = 1; i <= 200000; i++) {
+        wide_value v = {i, i, i, i};
+        lock.store(v);
+    }
+    done = true;
+    for (auto &t : readers) t.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(backwards.load(), 0);
+    EXPECT_EQ(lock.version(), 200000u);
+    EXPECT_EQ(lock.load().a, 200000u);
+}
+
+/**
+ * @brief wait_for retorna na hora com valor aceito e expira sem publicação
+ */
+TEST(LatestValue, WaitForTimeout) {
+    latest_value<wide_value> ch;
+    wide_value v = {7, 7, 7, 7};
+
+    EXPECT_FALSE(ch.wait_for(v, [](const wide_value &x) { return x.a > 0; }, std::chrono::milliseconds(5)));
+    EXPECT_EQ(v.a, 7u);   // unchanged on timeout
+
+    wide_value one = {1, 1, 1, 1};
+    ch.publish(one);
+    EXPECT_EQ(ch.version(), 1u);
+    EXPECT_TRUE(ch.wait_for(v, [](const wide_value &x) { return x.a > 0; }, std::chrono::milliseconds(0)));
+    EXPECT_EQ(v.a, 1u);
+}
+
+/**
+ * @brief Vários leitores em broadcast veem a publicação final
+ *
+ * Cada leitor espera sempre um valor mais novo que o último visto; valores
+ * intermediários podem ser pulados, mas nunca repetidos ou rasgados.
+ */
+TEST(LatestValue, BroadcastReaders) {
+    latest_value<wide_value> ch;
+    const unsigned long long LAST = 2000;
+    std::atomic<int> bad{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++) {
+        readers.emplace_back([&] {
+            unsigned long long last = 0;
+            while (last < LAST) {
+                wide_value v;
+                if (!ch.wait_for(v, [&](const wide_value &x) { return x.a > last; }, std::chrono::seconds(5))) {
+                    bad++;
+                    return;
+                }
+                if (v.a != v.d || v.a <= last) bad++;
+                last = v.a;
+            }
+        });
+    }
+
+    for (unsigned long long i = 1; i <= LAST; i++) {
+        wide_value v = {i, i, i, i};
+        ch.publish(v);
+        if (i % 100 == 0) std::this_thread::yield();
+    }
+    for (auto &t : readers) t.join();
+
+    EXPECT_EQ(bad.load(), 0);
+    EXPECT_EQ(ch.read().a, LAST);
+}
+
+/**
+ * @brief Leitores de source_A não esperam pelo trabalho do produtor
+ *
+ * O produtor passa 8ms de cada ciclo preparando o valor; com a
+ * publicação por seqlock nenhuma leitura deve ficar bloqueada nesse tempo.
+ */
+TEST(Seqlock, SourceAReadersDoNotWaitOnProducer) {
+    source_A source;
+    source.start();
+
+    buffer_source_A buf;
+    source.read(&buf);   // first publication
+    ASSERT_GT(buf.seq, 0u);
+
+    int slow = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < end) {
+        auto t0 = std::chrono::steady_clock::now();
+        source.read(&buf);
+        if (std::chrono::steady_clock::now() - t0 > std::chrono::milliseconds(2)) slow++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    source.stop();
+
+    EXPECT_LE(slow, 1);
+}
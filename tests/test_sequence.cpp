@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "source_threads.h"
+#include "source_process_threads.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+/// Prazo para esperas por publicações (source_A publica a cada ~53ms)
+std::chrono::steady_clock::time_point deadline() {
+    return std::chrono::steady_clock::now() + std::chrono::seconds(2);
+}
+}
+
+/**
+ * @brief Leitor rápido recebe cada publicação exatamente uma vez
+ */
+TEST(Sequence, ReadSinceWakesOncePerPublish) {
+    source_A source;
+    source.start();
+
+    unsigned long long last = 0;
+    int fresh = 0;
+    auto end = deadline();
+    while (fresh < 4) {
+        if (std::chrono::steady_clock::now() > end) {
+            source.stop();
+            FAIL() << "only " << fresh << " publications in 2s";
+        }
+        buffer_source_A buf;
+        long long skipped = source.read_since(last, &buf);
+        if (skipped < 0) continue;
+        EXPECT_EQ(skipped, 0);
+        EXPECT_EQ(buf.seq, last + 1);
+        last = buf.seq;
+        fresh++;
+    }
+
+    source.stop();
+}
+
+/**
+ * @brief Leitor lento é informado de quantas publicações perdeu
+ */
+TEST(Sequence, SlowReaderCountsSkipped) {
+    source_A source;
+    source.start();
+
+    buffer_source_A buf;
+    auto end = deadline();
+    while (source.read_since(0, &buf) < 0) {
+        if (std::chrono::steady_clock::now() > end) {
+            source.stop();
+            FAIL() << "no publication in 2s";
+        }
+    }
+    unsigned long long last = buf.seq;
+
+    // source_A publica a cada ~53ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    long long skipped = -1;
+    end = deadline();
+    while (skipped < 0) {
+        if (std::chrono::steady_clock::now() > end) {
+            source.stop();
+            FAIL() << "no publication after seq " << last << " in 2s";
+        }
+        skipped = source.read_since(last, &buf);
+    }
+    EXPECT_GE(skipped, 1);
+    EXPECT_EQ((unsigned long long)skipped, buf.seq - last - 1);
+
+    source.stop();
+}
+
+TEST(Sequence, ReadSinceTimesOutWithoutPublish) {
+    source_B source;
+    buffer_source_B buf;
+    EXPECT_EQ(source.read_since(0, &buf), -1);
+}
+
+TEST(Sequence, QueueItemsCarrySequence) {
+    source_A source;
+    channel<item_A> *ring = source.subscribe();
+    source.start();
+
+    unsigned long long expected = 1;
+    auto end = deadline();
+    while (expected <= 3) {
+        if (std::chrono::steady_clock::now() > end) {
+            source.stop();
+            FAIL() << "stuck waiting for seq " << expected;
+        }
+        item_A buf;
+        if (!ring->pop_wait(buf)) continue;
+        EXPECT_EQ(buf->head.seq, expected);
+        expected++;
+    }
+
+    source.stop();
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "spsc_ring.h"
+#include "source_threads.h"
+#include <thread>
+
+TEST(SpscRing, CapacityRoundsToPowerOfTwo) {
+    spsc_ring<int> r(5);
+    EXPECT_EQ(r.capacity(), 8u);
+
+    spsc_ring<int> d(0);
+    EXPECT_EQ(d.capacity(), default_queue_capacity);
+}
+
+TEST(SpscRing, FullAndEmpty) {
+    spsc_ring<int> r(4);
+    int v = 0;
+    EXPECT_FALSE(r.try_pop(v));
+
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(r.try_push(i));
+    EXPECT_FALSE(r.try_push(99));
+    EXPECT_EQ(r.size(), 4u);
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(r.try_pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_TRUE(r.empty());
+}
+
+TEST(SpscRing, BatchPushPopWrapsAround) {
+    spsc_ring<int> r(8);
+    int in[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int out[8] = {0};
+
+    // Desloca os índices para forçar o lote a cruzar o fim do buffer
+    EXPECT_EQ(r.try_push_batch(in, 5), 5u);
+    EXPECT_EQ(r.try_pop_batch(out, 5), 5u);
+
+    EXPECT_EQ(r.try_push_batch(in, 8), 8u);
+    EXPECT_EQ(r.try_push_batch(in, 1), 0u);
+
+    EXPECT_EQ(r.try_pop_batch(out, 3), 3u);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[2], 2);
+
+    // Apenas 3 posições livres: o lote é inserido parcialmente
+    EXPECT_EQ(r.try_push_batch(in, 8), 3u);
+
+    EXPECT_EQ(r.try_pop_batch(out, 8), 8u);
+    EXPECT_EQ(out[0], 3);
+    EXPECT_EQ(out[4], 7);
+    EXPECT_EQ(out[5], 0);
+    EXPECT_EQ(out[7], 2);
+    EXPECT_TRUE(r.empty());
+}
+
+/**
+ * @brief Produtor e consumidor em threads diferentes
+ * 
+ * Todos os itens devem chegar, em ordem, sem perdas
+ */
+TEST(SpscRing, ProducerConsumerPreservesOrder) {
+    const int N = 200000;
+    spsc_ring<int> r(16);
+
+    std::thread producer([&]() {
+        for (int i = 0; i < N; i++) {
+            while (!r.try_push(i)) std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    while (expected < N) {
+        int v;
+        if (r.try_pop(v)) {
+            ASSERT_EQ(v, expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(r.empty());
+}
+
+/**
+ * @brief Consumidor inscrito em source_A recebe todos os itens
+ * 
+ * source_A incrementa o valor em 5 a cada ciclo; nenhum item pode faltar
+ */
+TEST(SpscRing, SourceSubscriberMissesNothing) {
+    BenchConfig cfg;
+    cfg.queue_capacity = 4;
+    source_A source(&cfg);
+    channel<item_A> *ring = source.subscribe();
+    EXPECT_EQ(ring->capacity(), 4u);
+
+    source.start();
+
+    int last = 0;
+    int received = 0;
+    while (received < 3) {
+        item_A buf;
+        if (!ring->pop_wait(buf)) continue;
+        EXPECT_EQ(buf->head.data, last + 5);
+        last = buf->head.data;
+        received++;
+    }
+
+    source.stop();
+}
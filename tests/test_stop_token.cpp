@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "stop_token.h"
+#include "workload.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+typedef std::chrono::steady_clock clock_type;
+
+double ms_since(clock_type::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(clock_type::now() - t0).count();
+}
+}
+
+/**
+ * @brief request_stop() acorda um sleep_for() em andamento
+ */
+TEST(StopToken, StopCutsSleepShort) {
+    stop_source src;
+    stop_token tok = src.token();
+    EXPECT_TRUE(tok.stop_possible());
+    EXPECT_FALSE(tok.stop_requested());
+
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        src.request_stop();
+    });
+    auto t0 = clock_type::now();
+    EXPECT_FALSE(tok.sleep_for(std::chrono::seconds(5)));
+    EXPECT_LT(ms_since(t0), 1000.0);
+    stopper.join();
+    EXPECT_TRUE(tok.stop_requested());
+
+    src.reset();
+    EXPECT_FALSE(tok.stop_requested());
+    EXPECT_TRUE(tok.sleep_for(std::chrono::milliseconds(1)));
+}
+
+/**
+ * @brief Token padrão nunca é acionado: dorme o tempo todo
+ */
+TEST(StopToken, DefaultTokenSleepsFully) {
+    stop_token tok;
+    EXPECT_FALSE(tok.stop_possible());
+    auto t0 = clock_type::now();
+    EXPECT_TRUE(tok.sleep_for(std::chrono::milliseconds(20)));
+    EXPECT_GE(ms_since(t0), 19.0);
+}
+
+/**
+ * @brief workload::run() termina cedo depois do pedido de parada, nos kernels de sleep e de CPU
+ */
+TEST(StopToken, WorkloadReturnsEarly) {
+    for (workload_kind kind : { workload_kind::sleep, workload_kind::spin }) {
+        stop_source src;
+        workload w(kind);
+        w.set_stop_token(src.token());
+
+        std::thread stopper([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            src.request_stop();
+        });
+        auto t0 = clock_type::now();
+        w.run(std::chrono::seconds(5));
+        EXPECT_LT(ms_since(t0), 1000.0) << workload::kind_name(kind);
+        stopper.join();
+    }
+}
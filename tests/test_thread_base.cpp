@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include "thread_utils.h"
+#include "thread_pool.h"
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <mutex>
 
 struct TestThread : public thread_base {
     std::atomic<int> counter{0};
@@ -25,3 +28,67 @@ TEST(ThreadBase, StartStop) {
     EXPECT_FALSE(t.isActive());
     EXPECT_GT(t.counter.load(), 0);
 }
+
+/**
+ * @brief pause() estaciona a mesma thread; resume() a reaproveita
+ */
+TEST(ThreadBase, PauseResumeKeepsThread) {
+    struct IdThread : public thread_base {
+        std::atomic<int> counter{0};
+        std::mutex id_mtx;
+        std::thread::id id;
+        void run() override {
+            {
+                std::lock_guard<std::mutex> lk(id_mtx);
+                id = std::this_thread::get_id();
+            }
+            counter.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    } t;
+
+    t.start();
+    while (t.counter.load() < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    t.pause();
+    EXPECT_TRUE(t.paused());
+    EXPECT_FALSE(t.isActive());
+    std::thread::id first;
+    {
+        std::lock_guard<std::mutex> lk(t.id_mtx);
+        first = t.id;
+    }
+
+    int frozen = t.counter.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(t.counter.load(), frozen);
+
+    t.resume();
+    while (t.counter.load() < frozen + 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    {
+        std::lock_guard<std::mutex> lk(t.id_mtx);
+        EXPECT_EQ(t.id, first);
+    }
+
+    t.pause();
+    t.stop();   // stop while parked
+    EXPECT_FALSE(t.paused());
+}
+
+/**
+ * @brief No pool, pause() encerra a tarefa recorrente e resume() a agenda de novo
+ */
+TEST(ThreadBase, PauseResumeOnPool) {
+    thread_pool pool(2);
+    TestThread t;
+    t.start(&pool);
+    while (t.counter.load() < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    t.pause();
+    int frozen = t.counter.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(t.counter.load(), frozen);
+
+    t.resume();
+    while (t.counter.load() < frozen + 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    t.stop();
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "event_count.h"
+#include "pipeline.h"
+#include "bench_metrics.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+const wait_strategy all_strategies[] = {
+    wait_strategy::spin, wait_strategy::pause, wait_strategy::yield,
+    wait_strategy::park, wait_strategy::adaptive
+};
+}
+
+/**
+ * @brief Nomes da linha de comando e sobreposição por estágio
+ */
+TEST(WaitStrategy, ParsesNamesAndOverrides) {
+    for (wait_strategy s : all_strategies) {
+        wait_strategy parsed;
+        ASSERT_TRUE(wait_strategy_from_string(wait_strategy_name(s), parsed));
+        EXPECT_EQ(parsed, s);
+    }
+    wait_strategy parsed;
+    EXPECT_FALSE(wait_strategy_from_string("futex", parsed));
+
+    EXPECT_EQ(wait_strategy_for(nullptr, "pcB"), wait_strategy::adaptive);
+    BenchConfig cfg;
+    cfg.wait_strategy = "park";
+    cfg.channel_waits["pcB"] = "spin";
+    EXPECT_EQ(wait_strategy_for(&cfg, "pcA"), wait_strategy::park);
+    EXPECT_EQ(wait_strategy_for(&cfg, "pcB"), wait_strategy::spin);
+
+    cfg.channel_waits["pcA"] = "sometimes";
+    EXPECT_THROW(wait_strategy_for(&cfg, "pcA"), std::invalid_argument);
+}
+
+/**
+ * @brief Toda estratégia acorda com a notificação e respeita o timeout
+ */
+TEST(WaitStrategy, EveryStrategyWakesAndTimesOut) {
+    for (wait_strategy s : all_strategies) {
+        SCOPED_TRACE(wait_strategy_name(s));
+        event_count ev;
+        ev.set_strategy(s);
+
+        auto t0 = std::chrono::steady_clock::now();
+        EXPECT_FALSE(ev.wait_for(ev.prepare_wait(), std::chrono::milliseconds(3)));
+        EXPECT_GE(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(3));
+
+        std::atomic<bool> woke{false};
+        unsigned key = ev.prepare_wait();
+        std::thread waiter([&] { woke = ev.wait_for(key, std::chrono::seconds(5)); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        ev.notify_one();
+        waiter.join();
+        EXPECT_TRUE(woke.load());
+    }
+}
+
+/**
+ * @brief As variantes de spin nunca dormem; park dorme depois do spin
+ */
+TEST(WaitStrategy, SpinNeverParks) {
+    event_count spin;
+    spin.set_strategy(wait_strategy::pause);
+    spin.wait_for(spin.prepare_wait(), std::chrono::milliseconds(1));
+    EXPECT_EQ(spin.parks(), 0u);
+
+    event_count park;
+    park.set_strategy(wait_strategy::park);
+    park.wait_for(park.prepare_wait(), std::chrono::milliseconds(1));
+    EXPECT_EQ(park.parks(), 1u);
+
+    // A notification already seen before waiting returns without parking
+    unsigned key = park.prepare_wait();
+    park.notify_all();
+    EXPECT_TRUE(park.wait_for(key, std::chrono::seconds(1)));
+    EXPECT_EQ(park.parks(), 1u);
+}
+
+/**
+ * @brief Orçamento adaptativo cresce com eventos próximos e encolhe com esperas longas
+ */
+TEST(WaitStrategy, AdaptiveBudgetFollowsArrivals) {
+    using std::chrono::microseconds;
+    std::chrono::nanoseconds b = adaptive_spin_min;
+
+    b = adapt_spin_budget(b, true, microseconds(8));
+    EXPECT_EQ(b, 2 * adaptive_spin_min);
+    for (int i = 0; i < 20; i++) b = adapt_spin_budget(b, true, microseconds(20));
+    EXPECT_EQ(b, adaptive_spin_max);
+
+    b = adapt_spin_budget(b, true, microseconds(500));   // arrived long after the spin
+    EXPECT_EQ(b, adaptive_spin_max / 2);
+    for (int i = 0; i < 20; i++) b = adapt_spin_budget(b, false, std::chrono::milliseconds(20));
+    EXPECT_EQ(b, adaptive_spin_min);
+}
+
+/**
+ * @brief Estratégias por fila no Pipeline; estágio desconhecido é rejeitado
+ */
+TEST(WaitStrategy, PipelineUsesChannelWaits) {
+    BenchConfig cfg;
+    cfg.channel_waits["pcX"] = "spin";
+    EXPECT_THROW(PipelineBuilder::standard(&cfg).wait_strategies(), std::invalid_argument);
+
+    cfg.channel_waits.clear();
+    cfg.wait_strategy = "park";
+    cfg.channel_waits["pcB"] = "yield";
+    PipelineBuilder b = PipelineBuilder::standard(&cfg);
+    std::vector<wait_strategy> waits = b.wait_strategies();
+    EXPECT_EQ(waits[b.find("pcA")], wait_strategy::park);
+    EXPECT_EQ(waits[b.find("pcB")], wait_strategy::yield);
+
+    reset_processed_items();
+    Pipeline p(&cfg);
+    p.start();
+    auto t0 = std::chrono::steady_clock::now();
+    while (get_processed_items() < 3 && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(3))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    p.stop();
+
+    EXPECT_GE(get_processed_items(), 3);
+}
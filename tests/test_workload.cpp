@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "workload.h"
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+/// Tempo de parede de w.run(d), em ms
+double run_ms(workload &w, std::chrono::milliseconds d)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    w.run(d);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+}
+
+TEST(Workload, ParsesKinds) {
+    workload_kind k;
+    for (const char *name : {"sleep", "spin", "hash", "memory", "pointer_chase"}) {
+        ASSERT_TRUE(workload::kind_from_string(name, k));
+        EXPECT_STREQ(workload::kind_name(k), name);
+    }
+    EXPECT_FALSE(workload::kind_from_string("nap", k));
+}
+
+/**
+ * @brief Kernels calibrados executam aproximadamente o tempo pedido
+ *
+ * Limites folgados: a máquina de testes pode estar ocupada.
+ */
+TEST(Workload, CalibratedKernelsTrackRequestedTime) {
+    for (workload_kind k : {workload_kind::spin, workload_kind::hash,
+                            workload_kind::memory, workload_kind::pointer_chase}) {
+        workload w(k, 1u << 20);
+        EXPECT_GT(w.iterations_for(std::chrono::milliseconds(10)), 0u) << workload::kind_name(k);
+        EXPECT_EQ(w.iterations_for(std::chrono::nanoseconds(0)), 0u);
+
+        double ms = run_ms(w, std::chrono::milliseconds(20));
+        EXPECT_GT(ms, 5.0) << workload::kind_name(k);
+        EXPECT_LT(ms, 200.0) << workload::kind_name(k);
+    }
+}
+
+/**
+ * @brief Seleção por estágio a partir do BenchConfig
+ */
+TEST(Workload, SelectedPerStage) {
+    EXPECT_EQ(workload::for_stage(nullptr, "sA").kind(), workload_kind::sleep);
+
+    BenchConfig cfg;
+    cfg.workload = "spin";
+    cfg.stage_workloads["pcB"] = "hash";
+    cfg.workload_bytes = 64 * 1024;
+    EXPECT_EQ(workload::for_stage(&cfg, "sA").kind(), workload_kind::spin);
+    EXPECT_EQ(workload::for_stage(&cfg, "pcB").kind(), workload_kind::hash);
+
+    cfg.stage_workloads["sB"] = "nap";
+    EXPECT_THROW(workload::for_stage(&cfg, "sB"), std::invalid_argument);
+}
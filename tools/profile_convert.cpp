@@ -0,0 +1,69 @@
+// Offline converter for binary profile traces (see include/profile_trace.h)
+//
+//   profile_convert TRACE OUT [--format csv|chrome]
+//
+// Without --format, OUT ending in ".json" produces Chrome trace_event JSON
+// and anything else the thread,time,status CSV.
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "profile_trace.h"
+
+static void print_usage(const char *prog)
+{
+    printf("Usage: %s TRACE OUT [--format csv|chrome]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+    std::string in_path, out_path, format;
+
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--format")==0 && i+1<argc){ format = std::string(argv[++i]); }
+        else if(strcmp(argv[i],"--help")==0){ print_usage(argv[0]); return 0; }
+        else if(in_path.empty()){ in_path = argv[i]; }
+        else if(out_path.empty()){ out_path = argv[i]; }
+        else { printf("Unknown arg: %s\n", argv[i]); print_usage(argv[0]); return 1; }
+    }
+
+    if( in_path.empty() || out_path.empty() )
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if( format.empty() )
+    {
+        const std::string ext = ".json";
+        bool json = out_path.size() >= ext.size() && out_path.compare(out_path.size() - ext.size(), ext.size(), ext) == 0;
+        format = json ? "chrome" : "csv";
+    }
+    if( format != "csv" && format != "chrome" )
+    {
+        printf("Error: --format must be 'csv' or 'chrome'\n");
+        return 1;
+    }
+
+    std::ifstream in(in_path, std::ios::binary);
+    if( !in.is_open() )
+    {
+        printf("Error: cannot open trace '%s'\n", in_path.c_str());
+        return 1;
+    }
+    std::ofstream out(out_path);
+    if( !out.is_open() )
+    {
+        printf("Error: cannot open '%s' for writing\n", out_path.c_str());
+        return 1;
+    }
+
+    bool ok = format == "chrome" ? trace_to_chrome(in, out) : trace_to_csv(in, out);
+    if( !ok )
+    {
+        printf("Error: '%s' is not a valid profile trace (output truncated)\n", in_path.c_str());
+        return 1;
+    }
+    return 0;
+}